@@ -1,21 +1,75 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "BigNoob.h"
+#include "BigNoobFootprintUserData.h"
+#include "BigNoobGroundHeightTiles.h"
+#include "BigNoobGroundMeshCache.h"
+#include "BigNoobMeshBasePlane.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+
+#if WITH_EDITOR
+#include "Editor.h"
+#include "Subsystems/ImportSubsystem.h"
+#endif
 
 #define LOCTEXT_NAMESPACE "FBigNoobModule"
 
+LLM_DEFINE_TAG(BigNoob);
+
+static TAutoConsoleVariable<bool> CVarAttachFootprintOnImport(
+	TEXT("BigNoob.AttachFootprintOnImport"),
+	false,
+	TEXT("Attach alignment footprint data to every newly imported static mesh. Meshes that already carry it are always refreshed on reimport."));
+
 void FBigNoobModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
-	
+#if WITH_EDITOR
+	PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FBigNoobModule::RegisterImportHook);
+#endif
 }
 
 void FBigNoobModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
-	
+#if WITH_EDITOR
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+	if (GEditor && PostImportHandle.IsValid())
+	{
+		if (UImportSubsystem* ImportSubsystem = GEditor->GetEditorSubsystem<UImportSubsystem>())
+		{
+			ImportSubsystem->OnAssetPostImport.Remove(PostImportHandle);
+		}
+	}
+#endif
+	FBigNoobGroundMeshCache::Get().Reset();
+	FBigNoobGroundHeightTiles::ResetOpenFiles();
+	FBigNoobMeshBasePlaneCache::Get().Reset();
+}
+
+#if WITH_EDITOR
+void FBigNoobModule::RegisterImportHook()
+{
+	if (GEditor)
+	{
+		if (UImportSubsystem* ImportSubsystem = GEditor->GetEditorSubsystem<UImportSubsystem>())
+		{
+			PostImportHandle = ImportSubsystem->OnAssetPostImport.AddRaw(this, &FBigNoobModule::OnAssetPostImport);
+		}
+	}
+}
+
+void FBigNoobModule::OnAssetPostImport(UFactory* Factory, UObject* CreatedObject)
+{
+	UStaticMesh* StaticMesh = Cast<UStaticMesh>(CreatedObject);
+	if (StaticMesh && (CVarAttachFootprintOnImport.GetValueOnGameThread() || StaticMesh->GetAssetUserData<UBigNoobFootprintUserData>()))
+	{
+		UBigNoobFootprintUserData::FindOrAdd(StaticMesh);
+	}
 }
+#endif
 
 #undef LOCTEXT_NAMESPACE
 	
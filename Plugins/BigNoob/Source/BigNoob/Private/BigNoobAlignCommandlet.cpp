@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobAlignCommandlet.h"
+#include "BigNoobAlignTypes.h"
+#include "BigNoobBPLibrary.h"
+#include "BigNoobGroundTrace.h"
+#include "BigNoobLatencyStats.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UBigNoobAlignCommandlet::UBigNoobAlignCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBigNoobAlignCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	// Exact key lookups, FParse::Value would find Tag= inside -GroundTag=
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString MapName = ParamVals.FindRef(TEXT("Map"));
+	if (MapName.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("BigNoobAlign needs the map to align, -Map=/Game/Path/To/Map."));
+		return 1;
+	}
+
+	const FString* TagParam = ParamVals.Find(TEXT("Tag"));
+	const FString TagName = TagParam ? *TagParam : TEXT("BigNoobAlign");
+	const FName Tag(*TagName);
+	const FString GroundTagName = ParamVals.FindRef(TEXT("GroundTag"));
+	const bool bSave = !Switches.Contains(TEXT("NoSave"));
+
+	// Headless runs draw nothing. Probing only runs on every core against cached ground BVHs or height tiles
+	FBigNoobAlignOptions Options;
+	Options.bDrawDebug = false;
+	Options.bUseGroundMeshCache = true;
+	Options.ProfileReport.FilePath = ParamVals.FindRef(TEXT("Report"));
+	Options.GroundHeightTiles.FilePath = ParamVals.FindRef(TEXT("HeightTiles"));
+
+	if (const FString* EstimatorName = ParamVals.Find(TEXT("Estimator")))
+	{
+		const int64 Estimator = StaticEnum<EBigNoobPlaneEstimator>()->GetValueByNameString(*EstimatorName);
+		if (Estimator == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Unknown estimator %s."), **EstimatorName);
+			return 1;
+		}
+		Options.Estimator = (EBigNoobPlaneEstimator)Estimator;
+	}
+
+	FString PackageName = MapName;
+	if (!FPackageName::IsValidLongPackageName(PackageName) && !FPackageName::TryConvertFilenameToLongPackageName(MapName, PackageName))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a map in this project."), *MapName);
+		return 1;
+	}
+
+	const double LoadStart = FPlatformTime::Seconds();
+	UPackage* Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (World == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not load the map %s."), *PackageName);
+		return 1;
+	}
+
+	// A loaded map is not initialized, ground traces need its physics scene and registered components
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreatePhysicsScene(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false));
+	}
+	World->UpdateWorldComponents(true, false);
+	const double LoadSeconds = FPlatformTime::Seconds() - LoadStart;
+
+	TArray<AActor*> Actors;
+	const FName GroundTag(*GroundTagName);
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		if (It->ActorHasTag(Tag))
+		{
+			Actors.Add(*It);
+		}
+		else if (!GroundTagName.IsEmpty() && It->ActorHasTag(GroundTag))
+		{
+			TInlineComponentArray<UStaticMeshComponent*> GroundMeshes(*It);
+			for (UStaticMeshComponent* GroundMesh : GroundMeshes)
+			{
+				Options.GroundComponents.Add(GroundMesh);
+			}
+		}
+	}
+
+	if (!FBigNoobGroundTracer(World, Options).IsThreadSafe())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("BigNoobAlign traces the world's physics scene on one thread. Pass -GroundTag= for static mesh ground or -HeightTiles= to probe in parallel."));
+	}
+
+	FBigNoobLatencyStats::Get().Reset();
+	const double AlignStart = FPlatformTime::Seconds();
+	TArray<AActor*> MovedActors;
+	UBigNoobBPLibrary::ActorsAlignCollisionWithMovedActors(Actors, Options, MovedActors);
+	const double AlignSeconds = FPlatformTime::Seconds() - AlignStart;
+
+	int32 Result = 0;
+	const double SaveStart = FPlatformTime::Seconds();
+	if (bSave && MovedActors.Num() > 0)
+	{
+		// Moved actors include untagged ones attached under tagged actors. One file per actor maps keep them
+		// in their own packages, the others live in the package of their level, the map or a sublevel
+		TMap<UPackage*, AActor*> ActorPackages;
+		TSet<UPackage*> LevelPackages;
+		for (AActor* Actor : MovedActors)
+		{
+			if (UPackage* ExternalPackage = Actor->GetExternalPackage())
+			{
+				ActorPackages.Add(ExternalPackage, Actor);
+			}
+			else
+			{
+				LevelPackages.Add(Actor->GetPackage());
+			}
+		}
+
+		auto Save = [&Result](UPackage* SavedPackage, UObject* Asset, const FString& Filename, EObjectFlags TopLevelFlags)
+		{
+			if (IFileManager::Get().FileExists(*Filename) && IFileManager::Get().IsReadOnly(*Filename))
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s is read-only, check it out of source control before aligning."), *Filename);
+				Result = 1;
+				return;
+			}
+
+			FSavePackageArgs SaveArgs;
+			SaveArgs.TopLevelFlags = TopLevelFlags;
+			if (!UPackage::SavePackage(SavedPackage, Asset, *Filename, SaveArgs))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not save %s."), *Filename);
+				Result = 1;
+			}
+		};
+
+		for (UPackage* LevelPackage : LevelPackages)
+		{
+			Save(LevelPackage, UWorld::FindWorldInPackage(LevelPackage), FPackageName::LongPackageNameToFilename(LevelPackage->GetName(), FPackageName::GetMapPackageExtension()), RF_Standalone);
+		}
+
+		// External actors are not standalone, so each package is saved with its actor as the asset
+		for (const TPair<UPackage*, AActor*>& ActorPackage : ActorPackages)
+		{
+			Save(ActorPackage.Key, ActorPackage.Value, FPackageName::LongPackageNameToFilename(ActorPackage.Key->GetName(), FPackageName::GetAssetPackageExtension()), RF_NoFlags);
+		}
+	}
+	const double SaveSeconds = FPlatformTime::Seconds() - SaveStart;
+
+	UE_LOG(LogTemp, Display, TEXT("BigNoobAlign aligned %d actors tagged %s in %s, %d moved: load %.2fs, align %.2fs (%.1f actors/s), save %.2fs."),
+		Actors.Num(), *TagName, *PackageName, MovedActors.Num(), LoadSeconds, AlignSeconds, AlignSeconds > 0.0 ? Actors.Num() / AlignSeconds : 0.0, SaveSeconds);
+	FBigNoobLatencyStats::Get().Dump(*GLog);
+
+	World->CleanupWorld();
+	World->RemoveFromRoot();
+	return Result;
+#else
+	UE_LOG(LogTemp, Error, TEXT("BigNoobAlign needs an editor build to load and save maps."));
+	return 1;
+#endif
+}
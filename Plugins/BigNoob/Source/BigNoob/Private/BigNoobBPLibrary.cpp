@@ -2,226 +2,1052 @@
 
 #include "BigNoobBPLibrary.h"
 #include "BigNoob.h"
+#include "BigNoobFootprintUserData.h"
+#include "BigNoobGroundTrace.h"
+#include "BigNoobLatencyStats.h"
+#include "BigNoobMeshBasePlane.h"
+#include "BigNoobPlaneBatch.h"
+#include "BigNoobPlaneEstimators.h"
+#include "BigNoobProbeHistory.h"
+#include "BigNoobProbePatterns.h"
+#include "BigNoobRefinementPyramid.h"
+#include "Algo/StableSort.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Misc/FileHelper.h"
+#include "Misc/MemStack.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(BigNoob, true);
 
 //-------------------------------------------------------------------------------------------------------------------
 
-FVector CalculateCentroid(const TArray<FVector>& Points)
+struct FAlignJob
 {
-	FVector Centroid(0.f, 0.f, 0.f);
-	for (const FVector& Point : Points)
+	UStaticMeshComponent* Component = nullptr;
+	int32 InstanceIndex = INDEX_NONE; // Set when the job aligns one instance of an instanced component
+	FTransform WorldTransform;
+	FBoxSphereBounds Bounds;
+	FVector CenterOfMass;
+	FPlane LocalBasePlane;
+	const UBigNoobFootprintUserData* Footprint = nullptr;
+	FBigNoobProbeHistory* ProbeHistory = nullptr; // Only this job touches it while probing, components are gathered once
+
+	// Nearest aligned ancestor. Its job comes earlier in the list and moves this one rigidly with it
+	int32 ParentJob = INDEX_NONE;
+	int32 Depth = 0;
+	FTransform RelativeToParentJob;
+	FTransform AttachFrame; // Frame the component is attached to, relative to the parent job, or in world space without one
+	FBoxSphereBounds LocalBounds; // Bounds in the job's own space, the probe lattice is laid out over them
+	FVector LocalCenterOfMass;
+
+	TArray<FVector> HitPoints; // Only kept for debug drawing
+	TArray<FVector> DebugProbeStarts;
+	TArray<FBigNoobGroundPatch> GroundPatches; // Leaves of the refinement pyramid, when it is used
+
+	// Ground under the job once probed. Batched least squares fits leave their moments for the level's FitPlanesBatch
+	FBigNoobPlaneAccumulator GroundMoments;
+	FPlane GroundPlane;
+	bool bHasGroundPlane = false;
+
+	// Costs for the profile report. Batched stages are shared evenly between the jobs of the batch
+	int32 NumProbes = 0;
+	int32 NumHits = 0;
+	double SampleSeconds = 0.0;
+	double TraceSeconds = 0.0;
+	double FitSeconds = 0.0;
+	double ApplySeconds = 0.0;
+};
+
+// Per-call working memory lives on the calling thread's FMemStack, released by the FMemMark of the entry point
+using FAlignJobArray = TArray<FAlignJob, TMemStackAllocator<>>;
+using FMemStackSetAllocator = TSetAllocator<TSparseArrayAllocator<TMemStackAllocator<>, TMemStackAllocator<>>, TMemStackAllocator<>>;
+using FVisitedComponentSet = TSet<const USceneComponent*, DefaultKeyFuncs<const USceneComponent*>, FMemStackSetAllocator>;
+
+/** Fills in the placement of a job whose world transform and bounds are already set, relative to its parent job. */
+void SetAlignJobPlacement(FAlignJob& Job, const FAlignJobArray& Jobs, int32 ParentJob, const FTransform& AttachFrame)
+{
+	Job.ParentJob = ParentJob;
+	if (ParentJob != INDEX_NONE)
 	{
-		Centroid += Point;
+		const FTransform& ParentWorld = Jobs[ParentJob].WorldTransform;
+		Job.Depth = Jobs[ParentJob].Depth + 1;
+		Job.RelativeToParentJob = Job.WorldTransform.GetRelativeTransform(ParentWorld);
+		Job.AttachFrame = AttachFrame.GetRelativeTransform(ParentWorld);
 	}
-	return Centroid / Points.Num();
+	else
+	{
+		Job.AttachFrame = AttachFrame;
+	}
+	Job.LocalCenterOfMass = Job.WorldTransform.InverseTransformPosition(Job.CenterOfMass);
 }
 
-void RemoveOutliers(TArray<FVector>& Points, const FVector& Centroid, float Threshold)
+/**
+*	Adds a job for every static mesh component, or instance, attached under the actor's root, attached actors included.
+*	Components already in VisitedComponents are skipped, so an actor reached twice never gets two jobs for one component.
+*/
+void GatherAlignJobs(AActor* InActor, const FBigNoobAlignOptions& Options, FAlignJobArray& OutJobs, FVisitedComponentSet& VisitedComponents)
 {
-	float DistanceThresholdSquared = Threshold * Threshold;
-	for (int32 i = Points.Num() - 1; i >= 0; i--)
+	if (InActor == nullptr) 
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Get A nullptr InActor"));
+		return;
+	}
+
+	auto Root = InActor->GetRootComponent();
+	if (Root == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Get A nullptr Root"));
+		return;
+	}
+
+	struct FPendingComponent
+	{
+		USceneComponent* Component;
+		int32 ParentJob;
+	};
+
+	// Depth first over the whole attachment tree, so every job comes after the job of its aligned ancestor
+	TArray<FPendingComponent, TInlineAllocator<64>> Pending;
+	for (int32 ChildIndex = Root->GetAttachChildren().Num() - 1; ChildIndex >= 0; --ChildIndex)
 	{
-		if (FVector::DistSquared(Points[i], Centroid) > DistanceThresholdSquared)
+		Pending.Add({ Root->GetAttachChildren()[ChildIndex], INDEX_NONE });
+	}
+
+	while (Pending.Num() > 0)
+	{
+		const FPendingComponent Current = Pending.Pop(EAllowShrinking::No);
+		USceneComponent* Com = Current.Component;
+		if (Com == nullptr)
+		{
+			continue;
+		}
+
+		bool bAlreadyVisited = false;
+		VisitedComponents.Add(Com, &bAlreadyVisited);
+		if (bAlreadyVisited)
+		{
+			continue;
+		}
+
+		int32 ChildParentJob = Current.ParentJob;
+		UStaticMeshComponent* SmCom = Cast<UStaticMeshComponent>(Com);
+		if (SmCom)
+		{
+			// Precomputed footprint data replaces every read of the mesh's render and collision data
+			UStaticMesh* StaticMesh = SmCom->GetStaticMesh();
+			const UBigNoobFootprintUserData* Footprint = StaticMesh ? StaticMesh->GetAssetUserData<UBigNoobFootprintUserData>() : nullptr;
+			Footprint = Footprint && Footprint->ProbePoints.Num() > 0 ? Footprint : nullptr;
+
+			FPlane LocalBasePlane(FVector::ZeroVector, FVector::UpVector);
+			if (Options.bAlignMeshBasePlane)
+			{
+				LocalBasePlane = Footprint ? Footprint->BasePlane : FBigNoobMeshBasePlaneCache::Get().FindOrCompute(StaticMesh, Options.Estimator);
+			}
+
+			// Every instance becomes its own job, they share the mesh data looked up above.
+			// The component itself is not aligned, so its children keep following the parent job.
+			if (UInstancedStaticMeshComponent* IsmCom = Cast<UInstancedStaticMeshComponent>(SmCom))
+			{
+				if (StaticMesh)
+				{
+					const FBoxSphereBounds MeshBounds = StaticMesh->GetBounds();
+					const int32 NumInstances = IsmCom->GetInstanceCount();
+					OutJobs.Reserve(OutJobs.Num() + NumInstances);
+					for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+					{
+						FAlignJob& Job = OutJobs.AddDefaulted_GetRef();
+						Job.Component = IsmCom;
+						Job.InstanceIndex = InstanceIndex;
+						IsmCom->GetInstanceTransform(InstanceIndex, Job.WorldTransform, true);
+						Job.LocalBounds = MeshBounds;
+						Job.Bounds = MeshBounds.TransformBy(Job.WorldTransform);
+						Job.CenterOfMass = Footprint ? Job.WorldTransform.TransformPosition(Footprint->CenterOfMass) : Job.Bounds.Origin;
+						Job.LocalBasePlane = LocalBasePlane;
+						Job.Footprint = Footprint;
+						SetAlignJobPlacement(Job, OutJobs, Current.ParentJob, IsmCom->GetComponentTransform());
+					}
+				}
+			}
+			else
+			{
+				FAlignJob& Job = OutJobs.AddDefaulted_GetRef();
+				Job.Component = SmCom;
+				Job.WorldTransform = SmCom->GetComponentTransform();
+				Job.LocalBounds = SmCom->CalcBounds(FTransform::Identity);
+				Job.Bounds = SmCom->CalcBounds(Job.WorldTransform);
+				Job.LocalBasePlane = LocalBasePlane;
+				Job.Footprint = Footprint;
+
+				if (Job.Footprint)
+				{
+					Job.CenterOfMass = Job.WorldTransform.TransformPosition(Job.Footprint->CenterOfMass);
+				}
+				else
+				{
+					Job.CenterOfMass = SmCom->GetBodyInstance() && SmCom->GetBodyInstance()->IsValidBodyInstance() ? SmCom->GetCenterOfMass() : Job.Bounds.Origin;
+				}
+
+				const USceneComponent* AttachParent = SmCom->GetAttachParent();
+				const FTransform AttachFrame = AttachParent ? AttachParent->GetSocketTransform(SmCom->GetAttachSocketName()) : FTransform::Identity;
+				SetAlignJobPlacement(Job, OutJobs, Current.ParentJob, AttachFrame);
+				ChildParentJob = OutJobs.Num() - 1;
+			}
+		}
+
+		const TArray<TObjectPtr<USceneComponent>>& AttachChildren = Com->GetAttachChildren();
+		for (int32 ChildIndex = AttachChildren.Num() - 1; ChildIndex >= 0; --ChildIndex)
 		{
-			Points.RemoveAt(i);
+			Pending.Add({ AttachChildren[ChildIndex], ChildParentJob });
 		}
 	}
 }
 
-FPlane FitPlaneToPoints(const TArray<FVector>& Points)
+using FProbeArray = TArray<FVector, TMemStackAllocator<>>;
+
+/**
+*	Places the job's probes, each traces straight down from the bottom of the job's world bounds.
+*	Layouts are generated over the job's local bounds and transformed, so a yawed component
+*	gets the same probes as an unrotated one instead of covering its inflated world AABB.
+*/
+void GenerateAlignProbes(const FAlignJob& Job, const FBigNoobAlignOptions& Options, FProbeArray& OutStarts, FProbeArray& OutEnds)
 {
-	FVector Centroid = CalculateCentroid(Points);
+	FVector Min = Job.LocalBounds.GetBox().Min;
+	FVector Max = Job.LocalBounds.GetBox().Max;
+	float Z = Job.Bounds.GetBox().Min.Z;
+	float StepSize = FMath::Max(Options.StepSize, 1.0f);
+	const TArrayView<const BigNoobProbePatterns::FUnitPoint> Pattern = BigNoobProbePatterns::GetTable(Options.ProbePattern);
 
-	// Construct the covariance matrix
-	FMatrix CovarianceMatrix = FMatrix::Identity;
-	for (const FVector& Point : Points)
+	// Stack allocations cannot grow in place, so every layout is sized up front
+	const int32 NumGridProbes = (FMath::CeilToInt((Max.X - Min.X) / StepSize) + 1) * (FMath::CeilToInt((Max.Y - Min.Y) / StepSize) + 1);
+	const int32 NumPatternProbes = FMath::Min3(Options.MaxProbes, Pattern.Num(), Job.Footprint ? Options.MaxProbes : NumGridProbes);
+	const int32 NumProbes = Pattern.Num() > 0 ? NumPatternProbes : Job.Footprint ? Job.Footprint->ProbePoints.Num() : NumGridProbes;
+	OutStarts.Reserve(NumProbes);
+	OutEnds.Reserve(NumProbes);
+
+	auto AddProbe = [&OutStarts, &OutEnds, Z, &Options](const FVector& Probe)
 	{
-		FVector RelativePoint = Point - Centroid;
-		for (int32 i = 0; i < 3; ++i)
-			for (int32 j = 0; j < 3; ++j)
-				CovarianceMatrix.M[i][j] += RelativePoint[i] * RelativePoint[j];
-	}
+		OutStarts.Add(FVector(Probe.X, Probe.Y, Z));
+		OutEnds.Add(FVector(Probe.X, Probe.Y, Z - Options.TraceDistance));
+	};
 
-	// Find the eigenvalues and eigenvectors of the covariance matrix
-	// UE4/UE5 does not have a built-in method for this, so we approximate
-	// by assuming the smallest eigenvalue corresponds to the smallest row sum
-	FVector PlaneNormal;
-	float MinRowSum = MAX_flt;
-	for (int32 i = 0; i < 3; ++i)
+	// Lattice points on the bottom face of the local bounds
+	auto AddLocalProbe = [&AddProbe, &Job, &Min](double X, double Y)
+	{
+		AddProbe(Job.WorldTransform.TransformPosition(FVector(X, Y, Min.Z)));
+	};
+
+	if (Job.Footprint && Pattern.Num() > 0)
+	{
+		// Spread the pattern over the footprint's rectangle in base plane space and keep the points inside the hull
+		FVector AxisX, AxisY;
+		Job.Footprint->GetBaseAxes(AxisX, AxisY);
+		const FVector Origin = Job.Footprint->BasePlane.GetSafeNormal() * Job.Footprint->BasePlane.W;
+		const FBox2D Rect = Job.Footprint->GetFootprintBounds();
+		const FVector2D Size = Rect.GetSize();
+		for (int32 i = 0; i < Pattern.Num() && OutStarts.Num() < NumProbes; ++i)
+		{
+			const FVector2D Point = Rect.Min + FVector2D(Pattern[i].X * Size.X, Pattern[i].Y * Size.Y);
+			if (Job.Footprint->FootprintContains(Point))
+			{
+				AddProbe(Job.WorldTransform.TransformPosition(Origin + Point.X * AxisX + Point.Y * AxisY));
+			}
+		}
+	}
+	else if (Job.Footprint)
+	{
+		// Probe straight down under the mesh's own footprint instead of its whole bounds
+		for (const FVector& LocalProbe : Job.Footprint->ProbePoints)
+		{
+			AddProbe(Job.WorldTransform.TransformPosition(LocalProbe));
+		}
+	}
+	else if (Pattern.Num() > 0)
+	{
+		for (int32 i = 0; i < NumProbes; ++i)
+		{
+			AddLocalProbe(FMath::Lerp(Min.X, Max.X, (double)Pattern[i].X), FMath::Lerp(Min.Y, Max.Y, (double)Pattern[i].Y));
+		}
+	}
+	else if (Options.bProgressive)
+	{
+		// Coarse to fine: every level halves the spacing and only adds the lattice points the coarser levels skipped,
+		// so any prefix of the probes covers the whole footprint
+		const int32 NumX = FMath::Max(FMath::CeilToInt((Max.X - Min.X) / StepSize), 1);
+		const int32 NumY = FMath::Max(FMath::CeilToInt((Max.Y - Min.Y) / StepSize), 1);
+		const int32 CoarsestLevel = FMath::FloorLog2(FMath::Max(NumX, NumY));
+		for (int32 Level = CoarsestLevel; Level >= 0; --Level)
+		{
+			const int32 Stride = 1 << Level;
+			for (int32 ix = 0; ix < NumX; ix += Stride)
+			{
+				for (int32 iy = 0; iy < NumY; iy += Stride)
+				{
+					if (Level < CoarsestLevel && ix % (2 * Stride) == 0 && iy % (2 * Stride) == 0)
+					{
+						continue;
+					}
+					AddLocalProbe(Min.X + ix * StepSize, Min.Y + iy * StepSize);
+				}
+			}
+		}
+	}
+	else
 	{
-		float RowSum = CovarianceMatrix.M[i][0] + CovarianceMatrix.M[i][1] + CovarianceMatrix.M[i][2];
-		if (RowSum < MinRowSum)
+		for (float x = Min.X; x < Max.X; x += StepSize)
 		{
-			MinRowSum = RowSum;
-			PlaneNormal = FVector(CovarianceMatrix.M[i][0], CovarianceMatrix.M[i][1], CovarianceMatrix.M[i][2]);
+			for (float y = Min.Y; y < Max.Y; y += StepSize)
+			{
+				AddLocalProbe(x, y);
+			}
 		}
 	}
+}
+
+// Smallest hit count progressive sampling trusts, the plane needs a residual to judge its confidence
+static constexpr int32 MinProgressiveHits = 5;
+static constexpr int32 ProgressiveBatchSize = 4;
 
-	PlaneNormal.Normalize();
+// How much a missed adaptive probe's window grows before it is traced again
+static constexpr double AdaptiveRayGrowth = 4.0;
+
+/**
+*	Traces one batch of probes. With a predicted ground plane every probe only covers a short window
+*	around the predicted height, starting at most one margin above the full ray, and misses are
+*	widened and traced again until they hit or cover the full ray.
+*/
+void TraceProbeBatch(const FBigNoobGroundTracer& GroundTracer, const AActor* IgnoredActor, const FBigNoobAlignOptions& Options, const FPlane* PredictedGround,
+	TArrayView<FVector> Starts, TArrayView<FVector> Ends, TArrayView<FHitResult> OutHits, TArrayView<bool> bOutHits)
+{
+	if (PredictedGround == nullptr || FMath::Abs(PredictedGround->Z) < 0.1)
+	{
+		GroundTracer.TraceProbes(Starts, Ends, OutHits, bOutHits, IgnoredActor);
+		return;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+	const double InitialMargin = FMath::Max(Options.AdaptiveRayMargin, 1.0f);
+	TArray<double, TMemStackAllocator<>> PredictedZ;
+	TArray<double, TMemStackAllocator<>> FullTop;
+	TArray<double, TMemStackAllocator<>> FullBottom;
+	PredictedZ.Reserve(Starts.Num());
+	FullTop.Reserve(Starts.Num());
+	FullBottom.Reserve(Starts.Num());
+	for (int32 i = 0; i < Starts.Num(); ++i)
+	{
+		const double GroundZ = (PredictedGround->W - PredictedGround->X * Starts[i].X - PredictedGround->Y * Starts[i].Y) / PredictedGround->Z;
+		FullTop.Add(Starts[i].Z + InitialMargin);
+		FullBottom.Add(Ends[i].Z);
+		PredictedZ.Add(FMath::Clamp(GroundZ, Ends[i].Z, Starts[i].Z));
+		Starts[i].Z = FMath::Min(PredictedZ[i] + InitialMargin, FullTop[i]);
+		Ends[i].Z = FMath::Max(PredictedZ[i] - InitialMargin, FullBottom[i]);
+	}
+	GroundTracer.TraceProbes(Starts, Ends, OutHits, bOutHits, IgnoredActor);
+
+	FProbeArray RetryStarts;
+	FProbeArray RetryEnds;
+	TArray<FHitResult, TMemStackAllocator<>> RetryHits;
+	TArray<bool, TMemStackAllocator<>> bRetryHits;
+	TArray<int32, TMemStackAllocator<>> Misses;
+	for (double Margin = InitialMargin * AdaptiveRayGrowth;; Margin *= AdaptiveRayGrowth)
+	{
+		Misses.Reset();
+		RetryStarts.Reset();
+		RetryEnds.Reset();
+		for (int32 i = 0; i < Starts.Num(); ++i)
+		{
+			if (!bOutHits[i] && (Starts[i].Z < FullTop[i] || Ends[i].Z > FullBottom[i]))
+			{
+				Starts[i].Z = FMath::Min(PredictedZ[i] + Margin, FullTop[i]);
+				Ends[i].Z = FMath::Max(PredictedZ[i] - Margin, FullBottom[i]);
+				Misses.Add(i);
+				RetryStarts.Add(Starts[i]);
+				RetryEnds.Add(Ends[i]);
+			}
+		}
+		if (Misses.Num() == 0)
+		{
+			break;
+		}
 
-	return FPlane(Centroid, PlaneNormal);
+		RetryHits.SetNum(Misses.Num(), EAllowShrinking::No);
+		bRetryHits.SetNumZeroed(Misses.Num(), EAllowShrinking::No);
+		GroundTracer.TraceProbes(RetryStarts, RetryEnds, RetryHits, bRetryHits, IgnoredActor);
+		for (int32 m = 0; m < Misses.Num(); ++m)
+		{
+			if (bRetryHits[m])
+			{
+				OutHits[Misses[m]] = RetryHits[m];
+				bOutHits[Misses[m]] = true;
+			}
+		}
+	}
 }
 
-bool ConstructPlaneFromPoints(const FVector& A, const FVector& B, const FVector& C, FPlane& OutPlane)
+/**
+*	TraceProbeBatch that first takes every probe the job's history can reproject,
+*	then traces only the rest and records them for the next call.
+*/
+void TraceProbeBatchWithHistory(FBigNoobProbeHistory* History, int32 FirstProbe, const FBigNoobGroundTracer& GroundTracer, const AActor* IgnoredActor, const FBigNoobAlignOptions& Options,
+	const FPlane* PredictedGround, TArrayView<FVector> Starts, TArrayView<FVector> Ends, TArrayView<FHitResult> OutHits, TArrayView<bool> bOutHits)
 {
-	FVector AB = B - A;
-	FVector AC = C - A;
-	FVector CrossProduct = FVector::CrossProduct(AB, AC);
+	if (History == nullptr)
+	{
+		TraceProbeBatch(GroundTracer, IgnoredActor, Options, PredictedGround, Starts, Ends, OutHits, bOutHits);
+		return;
+	}
 
-	// ĲȽӽ㣬㹲
-	if (CrossProduct.SizeSquared() <= KINDA_SMALL_NUMBER)
+	FMemMark Mark(FMemStack::Get());
+	const double CellSize = FMath::Max(Options.ProbeHistoryCellSize, 1.0f);
+	TArray<bool, TMemStackAllocator<>> bReused;
+	bReused.SetNumZeroed(Starts.Num());
+	History->Reproject(FirstProbe, Starts, Ends, CellSize, OutHits, bOutHits, bReused);
+
+	TArray<int32, TMemStackAllocator<>> Traced;
+	FProbeArray TracedStarts;
+	FProbeArray TracedEnds;
+	for (int32 i = 0; i < Starts.Num(); ++i)
 	{
-		return false; // ߣ޷ƽ
+		if (!bReused[i])
+		{
+			Traced.Add(i);
+			TracedStarts.Add(Starts[i]);
+			TracedEnds.Add(Ends[i]);
+		}
 	}
+	if (Traced.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FHitResult, TMemStackAllocator<>> TracedHits;
+	TArray<bool, TMemStackAllocator<>> bTracedHits;
+	TracedHits.SetNum(Traced.Num());
+	bTracedHits.SetNumZeroed(Traced.Num());
+	TraceProbeBatch(GroundTracer, IgnoredActor, Options, PredictedGround, TracedStarts, TracedEnds, TracedHits, bTracedHits);
 
-	FVector Normal = CrossProduct.GetSafeNormal();
-	OutPlane = FPlane(A, Normal);
-	return true; // ɹƽ
+	for (int32 t = 0; t < Traced.Num(); ++t)
+	{
+		const int32 i = Traced[t];
+		History->Record(FirstProbe + i, Starts[i], TracedHits[t], bTracedHits[t], CellSize);
+		Starts[i] = TracedStarts[t];
+		Ends[i] = TracedEnds[t];
+		OutHits[i] = MoveTemp(TracedHits[t]);
+		bOutHits[i] = bTracedHits[t];
+	}
 }
 
-FPlane FindMedianPlane(const TArray<FVector>& HitPoints)
+/** Traces the job's probe layout, returns how many hits were compacted to the front of HitResults. */
+int32 SampleAlignProbes(FAlignJob& Job, const FBigNoobGroundTracer& GroundTracer, const FBigNoobAlignOptions& Options, TArray<FHitResult, TMemStackAllocator<>>& HitResults)
 {
-	TArray<FPlane> ValidPlanes;
-	int32 NumPoints = HitPoints.Num();
+	FProbeArray Starts;
+	FProbeArray Ends;
+	const double SampleStart = FPlatformTime::Seconds();
+	GenerateAlignProbes(Job, Options, Starts, Ends);
+	Job.SampleSeconds = FPlatformTime::Seconds() - SampleStart;
+
+	TArray<bool, TMemStackAllocator<>> bHits;
+	HitResults.SetNum(Starts.Num());
+	bHits.SetNumZeroed(Starts.Num());
+	if (Job.ProbeHistory)
+	{
+		Job.ProbeHistory->Prepare(Starts.Num());
+	}
 
-	// еƽ
-	for (int32 i = 0; i < NumPoints - 2; ++i)
+	// The lattice is traced as one batch so cached ground can run it as coherent ray packets.
+	// Progressive sampling traces small batches instead and stops once the plane is pinned down,
+	// adaptive rays do the same so every batch is predicted from the hits before it.
+	const bool bSmallBatches = Options.bProgressive || Options.bAdaptiveRayLength;
+	const int32 BatchSize = bSmallBatches ? FMath::Max(ProgressiveBatchSize, (int32)Options.RayPacketWidth) : Starts.Num();
+	const double ConeTolerance = FMath::DegreesToRadians((double)Options.ConfidenceConeDegrees);
+
+	// Until there are hits, the ground is predicted where the component's base currently rests, which is
+	// exactly right when it was aligned before
+	const FPlane CurrentBasePlane = Job.LocalBasePlane.TransformBy(Job.WorldTransform.ToMatrixWithScale());
+	FBigNoobPlaneAccumulator Accumulator;
+	int32 NumHits = 0;
+	int32 BatchStart = 0;
+	for (; BatchStart < Starts.Num(); BatchStart += BatchSize)
 	{
-		for (int32 j = i + 1; j < NumPoints - 1; ++j)
+		FPlane FittedGround;
+		const FPlane* PredictedGround = nullptr;
+		if (Options.bAdaptiveRayLength)
+		{
+			PredictedGround = Accumulator.GetPlane(FittedGround) ? &FittedGround : &CurrentBasePlane;
+		}
+
+		const int32 Count = FMath::Min(BatchSize, Starts.Num() - BatchStart);
+		TraceProbeBatchWithHistory(Job.ProbeHistory, BatchStart, GroundTracer, Job.Component->GetOwner(), Options, PredictedGround,
+			MakeArrayView(Starts).Slice(BatchStart, Count),
+			MakeArrayView(Ends).Slice(BatchStart, Count),
+			MakeArrayView(HitResults).Slice(BatchStart, Count),
+			MakeArrayView(bHits).Slice(BatchStart, Count));
+
+		// Compact the hits in place, the estimators then read ImpactPoint straight out of the hit results
+		for (int32 i = BatchStart; i < BatchStart + Count; ++i)
 		{
-			for (int32 k = j + 1; k < NumPoints; ++k)
+			if (bHits[i])
 			{
-				FPlane NewPlane;
-				if (ConstructPlaneFromPoints(HitPoints[i], HitPoints[j], HitPoints[k], NewPlane))
+				if (Options.bDrawDebug)
 				{
-					ValidPlanes.Add(NewPlane);
+					Job.HitPoints.Add(HitResults[i].ImpactPoint);
+					Job.DebugProbeStarts.Add(Starts[i]);
 				}
+				if (bSmallBatches)
+				{
+					Accumulator.Add(HitResults[i].ImpactPoint);
+				}
+				if (NumHits != i)
+				{
+					HitResults[NumHits] = MoveTemp(HitResults[i]);
+				}
+				++NumHits;
 			}
 		}
+
+		if (Options.bProgressive && Accumulator.Num() >= MinProgressiveHits && Accumulator.GetNormalConeAngle() <= ConeTolerance)
+		{
+			BatchStart += Count;
+			break;
+		}
 	}
 
-	// ÿз߼нǵܺ
-	float SmallestAngleSum = MAX_flt;
-	FPlane MedianPlane = ValidPlanes[0];
-	for (int32 i = 0; i < ValidPlanes.Num(); ++i)
+	// Probes skipped by progressive sampling hold hits from wherever the component was before
+	if (Job.ProbeHistory)
+	{
+		Job.ProbeHistory->ForgetFrom(BatchStart);
+	}
+	Job.NumProbes = FMath::Min(BatchStart, Starts.Num());
+	return NumHits;
+}
+
+// Runs on worker threads when the ground tracer allows it, so it must not touch the component
+void ProbeAlignJob(FAlignJob& Job, const FBigNoobGroundTracer& GroundTracer, const FBigNoobAlignOptions& Options)
+{
+	CSV_SCOPED_TIMING_STAT(BigNoob, ProbeJob);
+	FMemMark Mark(FMemStack::Get());
+	const double TraceStart = FPlatformTime::Seconds();
+	TArray<FHitResult, TMemStackAllocator<>> HitResults;
+	int32 NumHits = 0;
+	if (Options.bRefinementPyramid)
 	{
-		float AngleSum = 0.f;
-		for (int32 j = 0; j < ValidPlanes.Num(); ++j)
+		const FBox LocalBox = Job.LocalBounds.GetBox();
+		Job.NumProbes = RefineGroundPyramid(GroundTracer, Job.Component->GetOwner(), Options, Job.WorldTransform, FBox2D(FVector2D(LocalBox.Min), FVector2D(LocalBox.Max)), LocalBox.Min.Z, Job.Bounds.GetBox().Min.Z, HitResults, Job.GroundPatches);
+		NumHits = HitResults.Num();
+		if (Options.bDrawDebug)
 		{
-			if (i != j)
+			for (const FHitResult& Hit : HitResults)
 			{
-				// õ֮ĽǶ
-				float DotProduct = FVector::DotProduct(ValidPlanes[i].GetSafeNormal(), ValidPlanes[j].GetSafeNormal());
-				// ֹ򸡵㾫⵼µ[-1, 1]ķΧ
-				DotProduct = FMath::Clamp(DotProduct, -1.f, 1.f);
-				AngleSum += acosf(DotProduct);
+				Job.HitPoints.Add(Hit.ImpactPoint);
+				Job.DebugProbeStarts.Add(Hit.TraceStart);
 			}
 		}
+	}
+	else
+	{
+		NumHits = SampleAlignProbes(Job, GroundTracer, Options, HitResults);
+	}
+
+	const double FitStart = FPlatformTime::Seconds();
+	Job.TraceSeconds = FitStart - TraceStart - Job.SampleSeconds;
+	Job.NumHits = NumHits;
+	ON_SCOPE_EXIT
+	{
+		Job.FitSeconds += FPlatformTime::Seconds() - FitStart;
+	};
 
-		// λƽ
-		if (AngleSum < SmallestAngleSum)
+	const FBigNoobPointView HitPoints = FBigNoobPointView::FromImpactPoints(MakeArrayView(HitResults.GetData(), NumHits));
+	if (HitPoints.Num() < 3)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Not enough points to define a plane."));
+		return;
+	}
+
+	FPlane GroundPlane;
+	if (Job.ProbeHistory && !Options.bRefinementPyramid && Options.Estimator == EBigNoobPlaneEstimator::LeastSquares
+		&& Job.ProbeHistory->GetPlaneTracker().GetPlane(GroundPlane))
+	{
+		// Same fit as FindGroundPlane, updated with only the probes that changed since the last call
+		GroundPlane = GroundPlane.Z < 0.0 ? GroundPlane.Flip() : GroundPlane;
+	}
+	else if (Options.Estimator == EBigNoobPlaneEstimator::LeastSquares && Options.PlaneFitBatchWidth != EBigNoobRayPacketWidth::Scalar)
+	{
+		for (int32 i = 0; i < HitPoints.Num(); ++i)
 		{
-			SmallestAngleSum = AngleSum;
-			MedianPlane = ValidPlanes[i];
+			Job.GroundMoments.Add(HitPoints[i]);
 		}
+		return;
+	}
+	else
+	{
+		GroundPlane = FindGroundPlane(HitPoints, Options.Estimator, Job.CenterOfMass);
 	}
 
-	return MedianPlane;
+	Job.GroundPlane = GroundPlane;
+	Job.bHasGroundPlane = true;
 }
 
-FQuat FindQuatFromPlane(const TArray<FVector>& HitPoints)
+/** Solves the least squares fits a depth level left in GroundMoments, all in one batch. */
+void FitAlignJobPlanes(FAlignJobArray& Jobs, TArrayView<const int32> LevelJobs, const FBigNoobAlignOptions& Options)
 {
-	if (HitPoints.Num() < 3)
+	CSV_SCOPED_TIMING_STAT(BigNoob, FitPlanes);
+	FMemMark Mark(FMemStack::Get());
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<int32, TMemStackAllocator<>> BatchJobs;
+	TArray<const FBigNoobPlaneAccumulator*, TMemStackAllocator<>> BatchMoments;
+	for (int32 JobIndex : LevelJobs)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Not enough points to define a plane."));
-		return FQuat::Identity;
+		if (!Jobs[JobIndex].bHasGroundPlane && Jobs[JobIndex].GroundMoments.Num() > 0)
+		{
+			BatchJobs.Add(JobIndex);
+			BatchMoments.Add(&Jobs[JobIndex].GroundMoments);
+		}
+	}
+	if (BatchJobs.Num() == 0)
+	{
+		return;
 	}
 
-	FPlane BestPlane = FindMedianPlane(HitPoints);
-	FVector PlaneNormal = BestPlane.GetSafeNormal();
-
-	// ӷߵԪת߼ֲ
-	FVector UpVector(0.0f, 0.0f, 1.0f);
-	FVector RotationAxis = FVector::CrossProduct(UpVector, PlaneNormal).GetSafeNormal();
-	float RotationAngle = FMath::Acos(FVector::DotProduct(UpVector, PlaneNormal));
-	FQuat RotationQuat = FQuat(RotationAxis, RotationAngle);
+	TArray<FPlane, TMemStackAllocator<>> Planes;
+	TArray<bool, TMemStackAllocator<>> bValid;
+	Planes.SetNumUninitialized(BatchJobs.Num());
+	bValid.SetNumUninitialized(BatchJobs.Num());
+	FitPlanesBatch((int32)Options.PlaneFitBatchWidth, BatchMoments, Planes, bValid);
 
-	return RotationQuat;
+	const double SecondsPerJob = (FPlatformTime::Seconds() - StartTime) / BatchJobs.Num();
+	for (int32 i = 0; i < BatchJobs.Num(); ++i)
+	{
+		// Invalid fits already are the level plane FitPlaneToPoints falls back to
+		FAlignJob& Job = Jobs[BatchJobs[i]];
+		Job.GroundPlane = Planes[i].Z < 0.0 ? Planes[i].Flip() : Planes[i];
+		Job.bHasGroundPlane = true;
+		Job.FitSeconds += SecondsPerJob;
+	}
 }
 
-//-------------------------------------------------------------------------------------------------------------------
-
-UBigNoobBPLibrary::UBigNoobBPLibrary(const FObjectInitializer& ObjectInitializer)
-: Super(ObjectInitializer)
+/** Moves every job of a depth level that found ground onto its ground plane, the rotations are built in one batch. */
+void PlaceAlignJobs(FAlignJobArray& Jobs, TArrayView<const int32> LevelJobs, const FBigNoobAlignOptions& Options)
 {
+	CSV_SCOPED_TIMING_STAT(BigNoob, PlaceJobs);
+	FMemMark Mark(FMemStack::Get());
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<int32, TMemStackAllocator<>> Placed;
+	TArray<FPlane, TMemStackAllocator<>> GroundPlanes;
+	TArray<FQuat, TMemStackAllocator<>> Rotations;
+	TArray<FVector, TMemStackAllocator<>> LocalBaseNormals;
+	for (int32 JobIndex : LevelJobs)
+	{
+		const FAlignJob& Job = Jobs[JobIndex];
+		if (Job.bHasGroundPlane)
+		{
+			// Normals transform with the inverse scale, so squashed meshes keep their base flat on the ground
+			const FVector ScaleReciprocal = FTransform::GetSafeScaleReciprocal(Job.WorldTransform.GetScale3D());
+			Placed.Add(JobIndex);
+			GroundPlanes.Add(Job.GroundPlane);
+			Rotations.Add(Job.WorldTransform.GetRotation());
+			LocalBaseNormals.Add((Job.LocalBasePlane.GetSafeNormal() * ScaleReciprocal).GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector));
+		}
+	}
+
+	FindQuatsFromPlanes((int32)Options.PlaneFitBatchWidth, GroundPlanes, Rotations, LocalBaseNormals, Rotations);
 
+	const double RotationSecondsPerJob = Placed.Num() > 0 ? (FPlatformTime::Seconds() - StartTime) / Placed.Num() : 0.0;
+	for (int32 i = 0; i < Placed.Num(); ++i)
+	{
+		const double JobStart = FPlatformTime::Seconds();
+		ON_SCOPE_EXIT
+		{
+			Jobs[Placed[i]].FitSeconds += RotationSecondsPerJob + FPlatformTime::Seconds() - JobStart;
+		};
+
+		FAlignJob& Job = Jobs[Placed[i]];
+		Job.WorldTransform.SetRotation(Rotations[i]);
+
+		if (Options.bSnapToGround)
+		{
+			// Slide along the ground normal until the base plane and the ground plane coincide
+			const FPlane& GroundPlane = Job.GroundPlane;
+			const FVector LocalBasePoint = Job.LocalBasePlane.GetSafeNormal() * Job.LocalBasePlane.W;
+			const FVector WorldBasePoint = Job.WorldTransform.TransformPosition(LocalBasePoint);
+			Job.WorldTransform.AddToTranslation(-GroundPlane.PlaneDot(WorldBasePoint) * GroundPlane.GetSafeNormal());
+		}
+	}
 }
 
-float UBigNoobBPLibrary::BigNoobSampleFunction(float Param)
+/** Writes Options.ProfileReport, one row per job. */
+void WriteAlignProfileReport(const FAlignJobArray& Jobs, const FBigNoobAlignOptions& Options)
 {
-	return -1;
+	FString Path = Options.ProfileReport.FilePath;
+	if (FPaths::IsRelative(Path))
+	{
+		Path = FPaths::Combine(FPaths::ProfilingDir(), Path);
+	}
+
+	const FString Estimator = StaticEnum<EBigNoobPlaneEstimator>()->GetNameStringByValue((int64)Options.Estimator);
+	FString Report = TEXT("Component,Instance,Mesh,Probes,Hits,SampleMs,TraceMs,FitMs,ApplyMs,Estimator\n");
+	for (const FAlignJob& Job : Jobs)
+	{
+		Report += FString::Printf(TEXT("%s,%d,%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%s\n"),
+			*Job.Component->GetPathName(), Job.InstanceIndex, *GetPathNameSafe(Job.Component->GetStaticMesh()),
+			Job.NumProbes, Job.NumHits, Job.SampleSeconds * 1000.0, Job.TraceSeconds * 1000.0, Job.FitSeconds * 1000.0, Job.ApplySeconds * 1000.0, *Estimator);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Report, *Path))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write the alignment profile report to %s."), *Path);
+	}
 }
 
-void UBigNoobBPLibrary::ActorSceneComponentsAlignCollision(AActor* InActor)
+/** Aligns every static mesh component under the actors. OutMovedActors, when given, gets each actor whose saved transforms changed once. */
+void AlignActors(TArrayView<AActor* const> InActors, const FBigNoobAlignOptions& Options, TArray<AActor*>* OutMovedActors = nullptr)
 {
-	if (InActor == nullptr) 
+	CSV_SCOPED_TIMING_STAT(BigNoob, AlignActors);
+	LLM_SCOPE_BYTAG(BigNoob);
+	FMemMark Mark(FMemStack::Get());
+	const double RunStart = FPlatformTime::Seconds();
+	FAlignJobArray Jobs;
+	TArray<AActor*, TMemStackAllocator<>> UniqueActors;
+	UniqueActors.Reserve(InActors.Num());
+	UWorld* World = nullptr;
+	TSet<const AActor*, DefaultKeyFuncs<const AActor*>, FMemStackSetAllocator> ListedActors;
+	ListedActors.Reserve(InActors.Num());
+	for (AActor* Actor : InActors)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Get A nullptr InActor"));
-		return;
+		bool bAlreadyListed = false;
+		ListedActors.Add(Actor, &bAlreadyListed);
+		if (Actor == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Get A nullptr InActor"));
+		}
+		else if (!bAlreadyListed)
+		{
+			UniqueActors.Add(Actor);
+			World = World ? World : Actor->GetWorld();
+		}
 	}
 
-	auto Root = InActor->GetRootComponent();
-	if (Root == nullptr)
+	// Actors attached under another listed actor are gathered through it, so they still move rigidly with it.
+	// Those go last, where the visited set drops every component already gathered.
+	auto HasListedAncestor = [&ListedActors](const AActor* Actor)
+	{
+		for (const AActor* Parent = Actor->GetAttachParentActor(); Parent; Parent = Parent->GetAttachParentActor())
+		{
+			if (ListedActors.Contains(Parent))
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	FVisitedComponentSet VisitedComponents;
+	for (const bool bAttached : { false, true })
+	{
+		for (AActor* Actor : UniqueActors)
+		{
+			if (HasListedAncestor(Actor) == bAttached)
+			{
+				GatherAlignJobs(Actor, Options, Jobs, VisitedComponents);
+			}
+		}
+	}
+
+	if (Jobs.Num() == 0)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Get A nullptr Root"));
 		return;
 	}
 
-	TArray<USceneComponent*> Children;
-	Root->GetChildrenComponents(false,Children);
+	// Each job's probes only pass through its own actor, so stacked actors aligned together still rest on each other
+	const FBigNoobGroundTracer GroundTracer(World, Options);
 
-	for (auto Com : Children)
+	// Histories are looked up after gathering, adding to the subsystem's map must not race with the workers
+	UBigNoobProbeHistorySubsystem* ProbeHistory = Options.bReuseProbeHistory && World ? World->GetSubsystem<UBigNoobProbeHistorySubsystem>() : nullptr;
+	if (ProbeHistory)
 	{
-		UStaticMeshComponent* SmCom = Cast<UStaticMeshComponent>(Com);
-		if (SmCom)
+		ProbeHistory->PruneStale();
+#if DO_CHECK
+		TSet<const FBigNoobProbeHistory*, DefaultKeyFuncs<const FBigNoobProbeHistory*>, FMemStackSetAllocator> AssignedHistories;
+		AssignedHistories.Reserve(Jobs.Num());
+#endif
+		for (FAlignJob& Job : Jobs)
+		{
+			Job.ProbeHistory = &ProbeHistory->FindOrAdd(Job.Component, Job.InstanceIndex);
+#if DO_CHECK
+			// The workers prepare and record histories without locking
+			bool bAlreadyAssigned = false;
+			AssignedHistories.Add(Job.ProbeHistory, &bAlreadyAssigned);
+			checkf(!bAlreadyAssigned, TEXT("Two alignment jobs share the probe history of %s, instance %d."), *Job.Component->GetPathName(), Job.InstanceIndex);
+#endif
+		}
+	}
+
+	// Jobs under an aligned ancestor probe from where that ancestor will put them,
+	// so the tree is processed one attachment depth at a time
+	TArray<int32, TMemStackAllocator<>> JobOrder;
+	JobOrder.Reserve(Jobs.Num());
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		JobOrder.Add(JobIndex);
+	}
+	Algo::StableSortBy(JobOrder, [&Jobs](int32 JobIndex) { return Jobs[JobIndex].Depth; });
+
+	for (int32 LevelStart = 0; LevelStart < JobOrder.Num();)
+	{
+		const int32 Depth = Jobs[JobOrder[LevelStart]].Depth;
+		int32 LevelEnd = LevelStart + 1;
+		while (LevelEnd < JobOrder.Num() && Jobs[JobOrder[LevelEnd]].Depth == Depth)
+		{
+			++LevelEnd;
+		}
+
+		// Cached ground BVHs need no physics-scene lock, anything else is traced on the calling thread
+		ParallelFor(LevelEnd - LevelStart, [&Jobs, &JobOrder, &GroundTracer, &Options, LevelStart](int32 OrderIndex)
 		{
-			auto WorldTransform = SmCom->GetComponentTransform();
-			auto Bounds = SmCom->CalcBounds(WorldTransform);
-			//UE_LOG(LogTemp, Warning, TEXT("[Origin : %s] [Extend : %s]"),*Bounds.Origin.ToString(), *Bounds.BoxExtent.ToString());
+			// LLM scopes are per thread
+			LLM_SCOPE_BYTAG(BigNoob);
+			FAlignJob& Job = Jobs[JobOrder[LevelStart + OrderIndex]];
+			if (Job.ParentJob != INDEX_NONE)
+			{
+				Job.WorldTransform = Job.RelativeToParentJob * Jobs[Job.ParentJob].WorldTransform;
+				Job.Bounds = Job.LocalBounds.TransformBy(Job.WorldTransform);
+				Job.CenterOfMass = Job.WorldTransform.TransformPosition(Job.LocalCenterOfMass);
+			}
+			ProbeAlignJob(Job, GroundTracer, Options);
+		}, GroundTracer.IsThreadSafe() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+		// Fitting is cheap next to tracing, the level's jobs are placed together once every plane is known
+		const TArrayView<const int32> LevelJobs = MakeArrayView(JobOrder).Slice(LevelStart, LevelEnd - LevelStart);
+		FitAlignJobPlanes(Jobs, LevelJobs, Options);
+		PlaceAlignJobs(Jobs, LevelJobs, Options);
 
-			TArray<FVector> HitPoints;
-			FVector Min = Bounds.GetBox().Min;
-			FVector Max = Bounds.GetBox().Max;
-			float Z = Min.Z;
-			float StepSize = 50.0f;
-			for (float x = Min.X; x < Max.X; x += StepSize)
+		LevelStart = LevelEnd;
+	}
+
+	CSV_SCOPED_TIMING_STAT(BigNoob, Apply);
+
+	// Write every relative transform directly first, then update each moved subtree once from its
+	// topmost moved component, so nothing below it is re-dirtied once per aligned ancestor
+	TArray<bool, TMemStackAllocator<>> bSubtreeMoved;
+	bSubtreeMoved.SetNumZeroed(Jobs.Num());
+	TArray<int32, TMemStackAllocator<>> MovedSubtreeRoots;
+	const bool bGameWorld = World && World->IsGameWorld();
+
+	// Components below a moved one keep their relative transforms, only the written ones change what is saved
+	TSet<const AActor*, DefaultKeyFuncs<const AActor*>, FMemStackSetAllocator> MovedActorSet;
+	auto ReportMoved = [OutMovedActors, &MovedActorSet](UStaticMeshComponent* Component)
+	{
+		AActor* Owner = Component->GetOwner();
+		if (OutMovedActors == nullptr || Owner == nullptr)
+		{
+			return;
+		}
+
+		bool bAlreadyReported = false;
+		MovedActorSet.Add(Owner, &bAlreadyReported);
+		if (!bAlreadyReported)
+		{
+			OutMovedActors->Add(Owner);
+		}
+	};
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		FAlignJob& Job = Jobs[JobIndex];
+		if (Options.bDrawDebug)
+		{
+			for (int32 i = 0; i < Job.DebugProbeStarts.Num(); ++i)
 			{
-				for (float y = Min.Y; y < Max.Y; y += StepSize)
-				{
-					FVector Start = FVector(x, y, Z);
-					FVector End = FVector(x, y, Z - 1000.0f); 
-					FHitResult HitResult;
-					bool bHit = InActor->GetWorld()->LineTraceSingleByChannel(
-						HitResult,
-						Start,
-						End,
-						ECC_Visibility,
-						FCollisionQueryParams()
-					);
-
-					if (bHit)
-					{
-						DrawDebugLine(InActor->GetWorld(), Start, HitResult.ImpactPoint,FColor::Red, false, 5.0f, 0, 1.0f);
-						UE_LOG(LogTemp, Warning, TEXT("Hit at Location: %s"), *HitResult.ImpactPoint.ToString());
-						HitPoints.Add(HitResult.ImpactPoint);
-					}
-				}
+				DrawDebugLine(World, Job.DebugProbeStarts[i], Job.HitPoints[i], FColor::Red, false, 5.0f, 0, 1.0f);
+				UE_LOG(LogTemp, Warning, TEXT("Hit at Location: %s"), *Job.HitPoints[i].ToString());
 			}
+			for (const FBigNoobGroundPatch& Patch : Job.GroundPatches)
+			{
+				const FVector PatchPoint = FVector::PointPlaneProject(Patch.Center, Patch.Plane);
+				DrawDebugDirectionalArrow(World, PatchPoint, PatchPoint + Patch.Plane.GetSafeNormal() * 50.0f, 10.0f, FColor::MakeRedToGreenColorFromScalar(1.0f - (float)Patch.Depth / FMath::Max(Options.PyramidMaxDepth, 1)), false, 5.0f, 0, 1.0f);
+			}
+		}
+
+		// Debug drawing and logging stay out of the apply cost
+		const double ApplyStart = FPlatformTime::Seconds();
+		ON_SCOPE_EXIT
+		{
+			Job.ApplySeconds += FPlatformTime::Seconds() - ApplyStart;
+		};
+
+		if (Job.InstanceIndex != INDEX_NONE)
+		{
+			continue;
+		}
+
+		const bool bParentMoved = Job.ParentJob != INDEX_NONE && bSubtreeMoved[Job.ParentJob];
+		const FTransform AttachFrame = Job.ParentJob != INDEX_NONE ? Job.AttachFrame * Jobs[Job.ParentJob].WorldTransform : Job.AttachFrame;
+		const FTransform NewRelative = Job.WorldTransform.GetRelativeTransform(AttachFrame);
+
+		UStaticMeshComponent* Component = Job.Component;
+		const FVector NewLocation = Component->IsUsingAbsoluteLocation() ? Job.WorldTransform.GetLocation() : NewRelative.GetLocation();
+		const FRotator NewRotation = Component->IsUsingAbsoluteRotation() ? Job.WorldTransform.Rotator() : NewRelative.Rotator();
+		const FVector NewScale = Component->IsUsingAbsoluteScale() ? Job.WorldTransform.GetScale3D() : NewRelative.GetScale3D();
+
+		bool bMoved = !Component->GetRelativeLocation().Equals(NewLocation)
+			|| !Component->GetRelativeRotation().Equals(NewRotation)
+			|| !Component->GetRelativeScale3D().Equals(NewScale);
+
+		// The direct writes skip SetWorldTransform's mobility check, playing worlds only move movable components.
+		// Children of a component left in place are placed relative to where it really is.
+		if (bMoved && bGameWorld && Component->Mobility != EComponentMobility::Movable)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s is not movable, it is not aligned in a game world."), *Component->GetPathName());
+			Job.WorldTransform = Component->GetComponentTransform();
+			bMoved = false;
+		}
+
+		if (bMoved)
+		{
+			if (GIsEditor)
+			{
+				// Records the component for undo and dirties its level or external actor package
+				Component->Modify();
+			}
+			ReportMoved(Component);
+			Component->SetRelativeLocation_Direct(NewLocation);
+			Component->SetRelativeRotation_Direct(NewRotation);
+			Component->SetRelativeScale3D_Direct(NewScale);
+			if (!bParentMoved)
+			{
+				MovedSubtreeRoots.Add(JobIndex);
+			}
+		}
+		bSubtreeMoved[JobIndex] = bMoved || bParentMoved;
+	}
+
+	for (int32 JobIndex : MovedSubtreeRoots)
+	{
+		// The whole subtree's update is charged to its root
+		const double UpdateStart = FPlatformTime::Seconds();
+		Jobs[JobIndex].Component->UpdateComponentToWorld(EUpdateTransformFlags::None, ETeleportType::TeleportPhysics);
+		Jobs[JobIndex].ApplySeconds += FPlatformTime::Seconds() - UpdateStart;
+	}
+
+	// Instances are written in world space, so their components must already be in place
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		const FAlignJob& Job = Jobs[JobIndex];
 
-			FQuat BestRotation = FindQuatFromPlane(HitPoints);;
-			WorldTransform.SetRotation(BestRotation);
-			SmCom->SetWorldTransform(WorldTransform);
+		// Instance jobs of one component are contiguous and in instance order, so the whole
+		// run goes back in one batch with a single render state and physics update
+		if (Job.InstanceIndex == 0)
+		{
+			int32 RunEnd = JobIndex + 1;
+			while (RunEnd < Jobs.Num() && Jobs[RunEnd].Component == Job.Component && Jobs[RunEnd].InstanceIndex == RunEnd - JobIndex)
+			{
+				++RunEnd;
+			}
+
+			const double BatchStart = FPlatformTime::Seconds();
+			TArray<FTransform> InstanceTransforms;
+			InstanceTransforms.Reserve(RunEnd - JobIndex);
+			for (int32 RunIndex = JobIndex; RunIndex < RunEnd; ++RunIndex)
+			{
+				InstanceTransforms.Add(Jobs[RunIndex].WorldTransform);
+			}
+			if (GIsEditor)
+			{
+				Job.Component->Modify();
+			}
+			ReportMoved(Job.Component);
+			CastChecked<UInstancedStaticMeshComponent>(Job.Component)->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+
+			const double SecondsPerInstance = (FPlatformTime::Seconds() - BatchStart) / (RunEnd - JobIndex);
+			for (int32 RunIndex = JobIndex; RunIndex < RunEnd; ++RunIndex)
+			{
+				Jobs[RunIndex].ApplySeconds += SecondsPerInstance;
+			}
 		}
 	}
 
+	FBigNoobLatencyStats& LatencyStats = FBigNoobLatencyStats::Get();
+	for (const FAlignJob& Job : Jobs)
+	{
+		LatencyStats.RecordStage(EBigNoobAlignStage::Sample, Job.SampleSeconds);
+		LatencyStats.RecordStage(EBigNoobAlignStage::Trace, Job.TraceSeconds);
+		LatencyStats.RecordStage(EBigNoobAlignStage::Fit, Job.FitSeconds);
+		LatencyStats.RecordStage(EBigNoobAlignStage::Apply, Job.ApplySeconds);
+	}
+	LatencyStats.RecordRun(Jobs.Num(), FPlatformTime::Seconds() - RunStart);
+
+	if (!Options.ProfileReport.FilePath.IsEmpty())
+	{
+		WriteAlignProfileReport(Jobs, Options);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+
+UBigNoobBPLibrary::UBigNoobBPLibrary(const FObjectInitializer& ObjectInitializer)
+: Super(ObjectInitializer)
+{
+
+}
+
+float UBigNoobBPLibrary::BigNoobSampleFunction(float Param)
+{
+	return -1;
+}
+
+void UBigNoobBPLibrary::ActorSceneComponentsAlignCollision(AActor* InActor)
+{
+	ActorSceneComponentsAlignCollisionWithOptions(InActor, FBigNoobAlignOptions());
+}
+
+void UBigNoobBPLibrary::ActorSceneComponentsAlignCollisionWithOptions(AActor* InActor, const FBigNoobAlignOptions& Options)
+{
+	AlignActors(MakeArrayView(&InActor, 1), Options);
+}
+
+void UBigNoobBPLibrary::ActorsAlignCollision(const TArray<AActor*>& InActors, const FBigNoobAlignOptions& Options)
+{
+	AlignActors(InActors, Options);
+}
+
+void UBigNoobBPLibrary::ActorsAlignCollisionWithMovedActors(const TArray<AActor*>& InActors, const FBigNoobAlignOptions& Options, TArray<AActor*>& OutMovedActors)
+{
+	OutMovedActors.Reset();
+	AlignActors(InActors, Options, &OutMovedActors);
 }
 
+bool UBigNoobBPLibrary::BakeGroundHeightTiles(const UObject* WorldContextObject, const FBox& Bounds, const FBigNoobHeightTileBakeSettings& Settings, const FString& Filename)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+	return FBigNoobGroundHeightTiles::Bake(World, Bounds, Settings, Filename);
+}
+
+UBigNoobFootprintUserData* UBigNoobBPLibrary::AddFootprintUserData(UStaticMesh* StaticMesh)
+{
+	return UBigNoobFootprintUserData::FindOrAdd(StaticMesh);
+}
+
+FPlane UBigNoobBPLibrary::ProbeGroundPatches(UPrimitiveComponent* Component, const FBigNoobAlignOptions& Options, TArray<FBigNoobGroundPatch>& OutPatches)
+{
+	OutPatches.Reset();
+	if (Component == nullptr || Component->GetWorld() == nullptr)
+	{
+		return FPlane(FVector::ZeroVector, FVector::UpVector);
+	}
+
+	LLM_SCOPE_BYTAG(BigNoob);
+	FMemMark Mark(FMemStack::Get());
+	const FBigNoobGroundTracer GroundTracer(Component->GetWorld(), Options);
+
+	const FTransform& WorldTransform = Component->GetComponentTransform();
+	const FBox LocalBox = Component->CalcBounds(FTransform::Identity).GetBox();
+	const FBox WorldBox = Component->CalcBounds(WorldTransform).GetBox();
+	TArray<FHitResult, TMemStackAllocator<>> HitResults;
+	RefineGroundPyramid(GroundTracer, Component->GetOwner(), Options, WorldTransform, FBox2D(FVector2D(LocalBox.Min), FVector2D(LocalBox.Max)), LocalBox.Min.Z, WorldBox.Min.Z, HitResults, OutPatches);
+
+	if (HitResults.Num() < 3)
+	{
+		return FPlane(FVector(WorldBox.GetCenter().X, WorldBox.GetCenter().Y, WorldBox.Min.Z), FVector::UpVector);
+	}
+	return FindGroundPlane(FBigNoobPointView::FromImpactPoints(HitResults), Options.Estimator, WorldBox.GetCenter());
+}
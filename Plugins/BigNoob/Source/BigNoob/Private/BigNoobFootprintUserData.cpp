@@ -0,0 +1,190 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobFootprintUserData.h"
+#include "BigNoob.h"
+#include "BigNoobMeshBasePlane.h"
+#include "CompGeom/ConvexHull2.h"
+#include "Engine/StaticMesh.h"
+#include "Polygon2.h"
+#include "StaticMeshResources.h"
+#include "UObject/ObjectSaveContext.h"
+
+// Keeps huge meshes from storing huge probe layouts, the spacing grows instead
+static constexpr int32 MaxFootprintProbes = 1024;
+
+bool UBigNoobFootprintUserData::Rebuild(const UStaticMesh& StaticMesh)
+{
+	LLM_SCOPE_BYTAG(BigNoob);
+	TArray<FVector> BaseVertices;
+	const bool bHasVertices = ComputeMeshBasePlane(StaticMesh, EBigNoobPlaneEstimator::Support, BasePlane, &BaseVertices);
+
+	const FBox LocalBounds = StaticMesh.GetBoundingBox();
+	CenterOfMass = LocalBounds.GetCenter();
+	FootprintHull.Reset();
+	ProbePoints.Reset();
+
+	if (BaseVertices.Num() < 3)
+	{
+		// No usable vertex data, the bottom face of the bounds is the best footprint there is
+		BaseVertices = {
+			FVector(LocalBounds.Min.X, LocalBounds.Min.Y, LocalBounds.Min.Z),
+			FVector(LocalBounds.Max.X, LocalBounds.Min.Y, LocalBounds.Min.Z),
+			FVector(LocalBounds.Max.X, LocalBounds.Max.Y, LocalBounds.Min.Z),
+			FVector(LocalBounds.Min.X, LocalBounds.Max.Y, LocalBounds.Min.Z) };
+	}
+
+	FVector AxisX, AxisY;
+	GetBaseAxes(AxisX, AxisY);
+	const FVector Origin = BasePlane.GetSafeNormal() * BasePlane.W;
+
+	TArray<FVector2D> Projected;
+	Projected.Reserve(BaseVertices.Num());
+	FBox2D ProjectedBounds(ForceInit);
+	for (const FVector& Vertex : BaseVertices)
+	{
+		const FVector2D Point(FVector::DotProduct(Vertex - Origin, AxisX), FVector::DotProduct(Vertex - Origin, AxisY));
+		Projected.Add(Point);
+		ProjectedBounds += Point;
+	}
+
+	UE::Geometry::FConvexHull2d Hull;
+	if (Hull.Solve(Projected))
+	{
+		for (int32 Index : Hull.GetPolygonIndices())
+		{
+			FootprintHull.Add(Projected[Index]);
+		}
+	}
+	else
+	{
+		// Collinear base, e.g. a blade resting on its edge
+		FootprintHull = {
+			ProjectedBounds.Min,
+			FVector2D(ProjectedBounds.Max.X, ProjectedBounds.Min.Y),
+			ProjectedBounds.Max,
+			FVector2D(ProjectedBounds.Min.X, ProjectedBounds.Max.Y) };
+	}
+
+	// The hull corners decide what the mesh rests on, so they are always probed
+	for (const FVector2D& Corner : FootprintHull)
+	{
+		ProbePoints.Add(Origin + Corner.X * AxisX + Corner.Y * AxisY);
+	}
+
+	const UE::Geometry::FPolygon2d Polygon(FootprintHull);
+	const FVector2D Size = ProjectedBounds.GetSize();
+	const double Step = FMath::Max3((double)ProbeSpacing, FMath::Sqrt(Size.X * Size.Y / MaxFootprintProbes), 1.0);
+	for (double U = ProjectedBounds.Min.X + 0.5 * Step; U < ProjectedBounds.Max.X; U += Step)
+	{
+		for (double V = ProjectedBounds.Min.Y + 0.5 * Step; V < ProjectedBounds.Max.Y; V += Step)
+		{
+			if (Polygon.Contains(FVector2D(U, V)))
+			{
+				ProbePoints.Add(Origin + U * AxisX + V * AxisY);
+			}
+		}
+	}
+
+#if WITH_EDITORONLY_DATA
+	const FStaticMeshRenderData* RenderData = StaticMesh.GetRenderData();
+	SourceRenderDataKey = RenderData ? RenderData->DerivedDataKey : FString();
+#endif
+	return bHasVertices;
+}
+
+bool UBigNoobFootprintUserData::IsUpToDate(const UStaticMesh& StaticMesh) const
+{
+#if WITH_EDITORONLY_DATA
+	const FStaticMeshRenderData* RenderData = StaticMesh.GetRenderData();
+	return RenderData == nullptr || RenderData->DerivedDataKey == SourceRenderDataKey;
+#else
+	return true;
+#endif
+}
+
+void UBigNoobFootprintUserData::GetBaseAxes(FVector& OutAxisX, FVector& OutAxisY) const
+{
+	BasePlane.GetSafeNormal().FindBestAxisVectors(OutAxisX, OutAxisY);
+}
+
+FBox2D UBigNoobFootprintUserData::GetFootprintBounds() const
+{
+	return FBox2D(FootprintHull);
+}
+
+bool UBigNoobFootprintUserData::FootprintContains(const FVector2D& Point) const
+{
+	// The hull is convex, so the point is inside when it is on the same side of every edge
+	double Sign = 0.0;
+	for (int32 i = 0, Prev = FootprintHull.Num() - 1; i < FootprintHull.Num(); Prev = i++)
+	{
+		const double Side = FVector2D::CrossProduct(FootprintHull[i] - FootprintHull[Prev], Point - FootprintHull[Prev]);
+		if (Side * Sign < 0.0)
+		{
+			return false;
+		}
+		Sign = Side != 0.0 ? Side : Sign;
+	}
+	return FootprintHull.Num() >= 3;
+}
+
+UBigNoobFootprintUserData* UBigNoobFootprintUserData::FindOrAdd(UStaticMesh* StaticMesh)
+{
+	if (StaticMesh == nullptr)
+	{
+		return nullptr;
+	}
+
+	UBigNoobFootprintUserData* Footprint = StaticMesh->GetAssetUserData<UBigNoobFootprintUserData>();
+	if (Footprint == nullptr)
+	{
+		Footprint = NewObject<UBigNoobFootprintUserData>(StaticMesh, NAME_None, RF_Transactional);
+		StaticMesh->AddAssetUserData(Footprint);
+		Footprint->Rebuild(*StaticMesh);
+		StaticMesh->MarkPackageDirty();
+	}
+	else if (!Footprint->IsUpToDate(*StaticMesh) || Footprint->ProbePoints.Num() == 0)
+	{
+		Footprint->Rebuild(*StaticMesh);
+		StaticMesh->MarkPackageDirty();
+	}
+	return Footprint;
+}
+
+#if WITH_EDITOR
+void UBigNoobFootprintUserData::PostEditChangeOwner()
+{
+	Super::PostEditChangeOwner();
+
+	// The owner was rebuilt or reimported
+	if (const UStaticMesh* StaticMesh = GetTypedOuter<UStaticMesh>())
+	{
+		Rebuild(*StaticMesh);
+	}
+}
+
+void UBigNoobFootprintUserData::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(UBigNoobFootprintUserData, ProbeSpacing))
+	{
+		if (const UStaticMesh* StaticMesh = GetTypedOuter<UStaticMesh>())
+		{
+			Rebuild(*StaticMesh);
+		}
+	}
+}
+
+void UBigNoobFootprintUserData::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	// Catches meshes whose render data changed without the owner telling us, cooked data is never stale
+	const UStaticMesh* StaticMesh = GetTypedOuter<UStaticMesh>();
+	if (StaticMesh && !IsUpToDate(*StaticMesh))
+	{
+		Rebuild(*StaticMesh);
+	}
+}
+#endif
@@ -0,0 +1,360 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobGroundHeightTiles.h"
+#include "BigNoob.h"
+#include "BigNoobAlignTypes.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace BigNoobHeightTiles
+{
+	FCriticalSection OpenFilesLock;
+	TMap<FString, FBigNoobGroundHeightTilesPtr> OpenFiles;
+
+	// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+	void EncodeNormal(const FVector& Normal, uint8& OutU, uint8& OutV)
+	{
+		const FVector N = Normal / FMath::Max(FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z), UE_SMALL_NUMBER);
+		double U = N.X;
+		double V = N.Y;
+		if (N.Z < 0.0)
+		{
+			U = (1.0 - FMath::Abs(N.Y)) * (N.X >= 0.0 ? 1.0 : -1.0);
+			V = (1.0 - FMath::Abs(N.X)) * (N.Y >= 0.0 ? 1.0 : -1.0);
+		}
+		OutU = (uint8)FMath::Clamp(FMath::RoundToInt((U * 0.5 + 0.5) * 255.0), 0, 255);
+		OutV = (uint8)FMath::Clamp(FMath::RoundToInt((V * 0.5 + 0.5) * 255.0), 0, 255);
+	}
+
+	FVector DecodeNormal(uint8 InU, uint8 InV)
+	{
+		const double U = InU / 255.0 * 2.0 - 1.0;
+		const double V = InV / 255.0 * 2.0 - 1.0;
+		FVector N(U, V, 1.0 - FMath::Abs(U) - FMath::Abs(V));
+		const double T = FMath::Max(-N.Z, 0.0);
+		N.X += N.X >= 0.0 ? -T : T;
+		N.Y += N.Y >= 0.0 ? -T : T;
+		return N.GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector);
+	}
+}
+
+FBigNoobGroundHeightTiles::~FBigNoobGroundHeightTiles()
+{
+	// Regions must be unmapped before the file handle goes away
+	TileRegions.Reset();
+	TableRegion.Reset();
+	MappedFile.Reset();
+}
+
+FBigNoobGroundHeightTilesPtr FBigNoobGroundHeightTiles::FindOrOpen(const FString& Filename)
+{
+	LLM_SCOPE_BYTAG(BigNoob);
+	using namespace BigNoobHeightTiles;
+
+	if (Filename.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	const FString FullPath = FPaths::ConvertRelativePathToFull(Filename);
+
+	FScopeLock Lock(&OpenFilesLock);
+	if (const FBigNoobGroundHeightTilesPtr* Found = OpenFiles.Find(FullPath))
+	{
+		return *Found;
+	}
+
+	TSharedPtr<FBigNoobGroundHeightTiles, ESPMode::ThreadSafe> Tiles(new FBigNoobGroundHeightTiles());
+	if (!Tiles->Open(FullPath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to open ground height tiles %s"), *FullPath);
+		return nullptr;
+	}
+
+	OpenFiles.Add(FullPath, Tiles);
+	return Tiles;
+}
+
+void FBigNoobGroundHeightTiles::ResetOpenFiles()
+{
+	using namespace BigNoobHeightTiles;
+
+	FScopeLock Lock(&OpenFilesLock);
+	OpenFiles.Reset();
+}
+
+bool FBigNoobGroundHeightTiles::Open(const FString& Filename)
+{
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() < (int64)sizeof(FBigNoobHeightTileHeader))
+	{
+		return false;
+	}
+
+	{
+		TUniquePtr<IMappedFileRegion> HeaderRegion(MappedFile->MapRegion(0, sizeof(FBigNoobHeightTileHeader)));
+		if (!HeaderRegion.IsValid())
+		{
+			return false;
+		}
+		FMemory::Memcpy(&Header, HeaderRegion->GetMappedPtr(), sizeof(FBigNoobHeightTileHeader));
+	}
+
+	if (Header.Magic != FBigNoobHeightTileHeader::ExpectedMagic
+		|| Header.Version != FBigNoobHeightTileHeader::ExpectedVersion
+		|| Header.CellSize <= 0.0f
+		|| Header.TileResolution <= 0
+		|| Header.NumTilesX <= 0
+		|| Header.NumTilesY <= 0
+		|| Header.NumLayers <= 0)
+	{
+		return false;
+	}
+
+	const int32 NumTiles = Header.NumTilesX * Header.NumTilesY;
+	const int64 TableBytes = (int64)NumTiles * sizeof(uint64);
+	if (MappedFile->GetFileSize() < (int64)sizeof(FBigNoobHeightTileHeader) + TableBytes)
+	{
+		return false;
+	}
+
+	TableRegion.Reset(MappedFile->MapRegion(sizeof(FBigNoobHeightTileHeader), TableBytes));
+	if (!TableRegion.IsValid())
+	{
+		return false;
+	}
+
+	TileOffsets = reinterpret_cast<const uint64*>(TableRegion->GetMappedPtr());
+	TileBytes = (int64)Header.NumLayers * Header.TileResolution * Header.TileResolution * sizeof(FBigNoobHeightTileSample);
+
+	TileRegions.SetNum(NumTiles);
+	TileSamples = MakeUnique<std::atomic<const FBigNoobHeightTileSample*>[]>(NumTiles);
+	for (int32 TileIndex = 0; TileIndex < NumTiles; ++TileIndex)
+	{
+		TileSamples[TileIndex].store(nullptr, std::memory_order_relaxed);
+	}
+	return true;
+}
+
+const FBigNoobHeightTileSample* FBigNoobGroundHeightTiles::GetTileSamples(int32 TileIndex) const
+{
+	const uint64 Offset = TileOffsets[TileIndex];
+	if (Offset == 0)
+	{
+		return nullptr;
+	}
+
+	const FBigNoobHeightTileSample* Samples = TileSamples[TileIndex].load(std::memory_order_acquire);
+	if (Samples)
+	{
+		return Samples;
+	}
+
+	FScopeLock Lock(&MapLock);
+	Samples = TileSamples[TileIndex].load(std::memory_order_relaxed);
+	if (Samples == nullptr && Offset + TileBytes <= (uint64)MappedFile->GetFileSize())
+	{
+		TileRegions[TileIndex].Reset(MappedFile->MapRegion(Offset, TileBytes));
+		if (TileRegions[TileIndex].IsValid())
+		{
+			Samples = reinterpret_cast<const FBigNoobHeightTileSample*>(TileRegions[TileIndex]->GetMappedPtr());
+			TileSamples[TileIndex].store(Samples, std::memory_order_release);
+		}
+	}
+	return Samples;
+}
+
+const FBigNoobHeightTileSample* FBigNoobGroundHeightTiles::FindSample(int32 SampleX, int32 SampleY, double MaxZ) const
+{
+	const int32 Resolution = Header.TileResolution;
+	const int32 TileX = SampleX / Resolution;
+	const int32 TileY = SampleY / Resolution;
+	if (SampleX < 0 || SampleY < 0 || TileX >= Header.NumTilesX || TileY >= Header.NumTilesY)
+	{
+		return nullptr;
+	}
+
+	const FBigNoobHeightTileSample* Samples = GetTileSamples(TileY * Header.NumTilesX + TileX);
+	if (Samples == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Layers are stored top first, take the first one the probe starts above
+	const int32 InTileIndex = (SampleY - TileY * Resolution) * Resolution + (SampleX - TileX * Resolution);
+	for (int32 Layer = 0; Layer < Header.NumLayers; ++Layer)
+	{
+		const FBigNoobHeightTileSample& Sample = Samples[Layer * Resolution * Resolution + InTileIndex];
+		if (Sample.IsEmpty())
+		{
+			break;
+		}
+		if (Header.MinZ + Sample.Height * Header.HeightScale <= MaxZ)
+		{
+			return &Sample;
+		}
+	}
+	return nullptr;
+}
+
+bool FBigNoobGroundHeightTiles::Sample(double X, double Y, double MaxZ, double MinZ, FVector& OutPoint, FVector& OutNormal) const
+{
+	const double GridX = (X - Header.OriginX) / Header.CellSize;
+	const double GridY = (Y - Header.OriginY) / Header.CellSize;
+	const int32 X0 = FMath::FloorToInt32(GridX);
+	const int32 Y0 = FMath::FloorToInt32(GridY);
+	const double FracX = GridX - X0;
+	const double FracY = GridY - Y0;
+
+	const int32 CornerX[4] = { X0, X0 + 1, X0, X0 + 1 };
+	const int32 CornerY[4] = { Y0, Y0, Y0 + 1, Y0 + 1 };
+	const double CornerWeight[4] = { (1.0 - FracX) * (1.0 - FracY), FracX * (1.0 - FracY), (1.0 - FracX) * FracY, FracX * FracY };
+
+	// Corners without ground are dropped and the remaining weights renormalised, so edges of the baked area stay usable
+	double WeightSum = 0.0;
+	double Height = 0.0;
+	FVector Normal = FVector::ZeroVector;
+	for (int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		if (CornerWeight[Corner] <= 0.0)
+		{
+			continue;
+		}
+
+		const FBigNoobHeightTileSample* Sample = FindSample(CornerX[Corner], CornerY[Corner], MaxZ);
+		if (Sample)
+		{
+			WeightSum += CornerWeight[Corner];
+			Height += CornerWeight[Corner] * (Header.MinZ + Sample->Height * Header.HeightScale);
+			Normal += CornerWeight[Corner] * BigNoobHeightTiles::DecodeNormal(Sample->NormalU, Sample->NormalV);
+		}
+	}
+
+	if (WeightSum <= UE_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	Height /= WeightSum;
+	if (Height < MinZ || Height > MaxZ)
+	{
+		return false;
+	}
+
+	OutPoint = FVector(X, Y, Height);
+	OutNormal = Normal.GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector);
+	return true;
+}
+
+bool FBigNoobGroundHeightTiles::Bake(UWorld* World, const FBox& Bounds, const FBigNoobHeightTileBakeSettings& Settings, const FString& Filename)
+{
+	LLM_SCOPE_BYTAG(BigNoob);
+	if (World == nullptr || !Bounds.IsValid)
+	{
+		return false;
+	}
+
+	const FString FullPath = FPaths::ConvertRelativePathToFull(Filename);
+	{
+		// A mapped file cannot be overwritten on every platform, let go of our own mapping first
+		FScopeLock Lock(&BigNoobHeightTiles::OpenFilesLock);
+		BigNoobHeightTiles::OpenFiles.Remove(FullPath);
+	}
+
+	FBigNoobHeightTileHeader BakeHeader;
+	BakeHeader.OriginX = Bounds.Min.X;
+	BakeHeader.OriginY = Bounds.Min.Y;
+	BakeHeader.CellSize = FMath::Max(Settings.CellSize, 1.0f);
+	BakeHeader.TileResolution = FMath::Clamp(Settings.TileResolution, 4, 1024);
+	BakeHeader.NumLayers = FMath::Clamp(Settings.MaxLayers, 1, 16);
+	BakeHeader.MinZ = Bounds.Min.Z;
+	BakeHeader.HeightScale = FMath::Max((float)(Bounds.Max.Z - Bounds.Min.Z) / (FBigNoobHeightTileSample::EmptyHeight - 1), UE_KINDA_SMALL_NUMBER);
+
+	const int32 NumSamplesX = FMath::CeilToInt32((Bounds.Max.X - Bounds.Min.X) / BakeHeader.CellSize) + 1;
+	const int32 NumSamplesY = FMath::CeilToInt32((Bounds.Max.Y - Bounds.Min.Y) / BakeHeader.CellSize) + 1;
+	BakeHeader.NumTilesX = FMath::DivideAndRoundUp(NumSamplesX, BakeHeader.TileResolution);
+	BakeHeader.NumTilesY = FMath::DivideAndRoundUp(NumSamplesY, BakeHeader.TileResolution);
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FullPath));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to create ground height tiles %s"), *FullPath);
+		return false;
+	}
+
+	TArray<uint64> Offsets;
+	Offsets.SetNumZeroed(BakeHeader.NumTilesX * BakeHeader.NumTilesY);
+	Writer->Serialize(&BakeHeader, sizeof(BakeHeader));
+	Writer->Serialize(Offsets.GetData(), Offsets.Num() * sizeof(uint64));
+
+	const int32 Resolution = BakeHeader.TileResolution;
+	const double WalkableZ = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(Settings.WalkableFloorAngle, 0.0f, 90.0f)));
+	const double LayerSeparation = FMath::Max(Settings.MinLayerSeparation, 1.0f);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BigNoobHeightTileBake), false);
+
+	TArray<FBigNoobHeightTileSample> BakedSamples;
+	for (int32 TileY = 0; TileY < BakeHeader.NumTilesY; ++TileY)
+	{
+		for (int32 TileX = 0; TileX < BakeHeader.NumTilesX; ++TileX)
+		{
+			BakedSamples.Reset();
+			BakedSamples.SetNum(BakeHeader.NumLayers * Resolution * Resolution);
+
+			bool bAnyGround = false;
+			for (int32 j = 0; j < Resolution; ++j)
+			{
+				for (int32 i = 0; i < Resolution; ++i)
+				{
+					const int32 SampleX = TileX * Resolution + i;
+					const int32 SampleY = TileY * Resolution + j;
+					if (SampleX >= NumSamplesX || SampleY >= NumSamplesY)
+					{
+						continue;
+					}
+
+					const double X = BakeHeader.OriginX + SampleX * BakeHeader.CellSize;
+					const double Y = BakeHeader.OriginY + SampleY * BakeHeader.CellSize;
+
+					// Walk down through the level, recording each walkable surface as its own layer
+					double TopZ = Bounds.Max.Z;
+					int32 Layer = 0;
+					for (int32 Step = 0; Step < BakeHeader.NumLayers * 4 && Layer < BakeHeader.NumLayers && TopZ > Bounds.Min.Z; ++Step)
+					{
+						FHitResult Hit;
+						if (!World->LineTraceSingleByChannel(Hit, FVector(X, Y, TopZ), FVector(X, Y, Bounds.Min.Z), Settings.TraceChannel, QueryParams))
+						{
+							break;
+						}
+
+						if (Hit.ImpactNormal.Z >= WalkableZ)
+						{
+							FBigNoobHeightTileSample& Sample = BakedSamples[(Layer * Resolution + j) * Resolution + i];
+							Sample.Height = (uint16)FMath::Clamp(FMath::RoundToInt((Hit.ImpactPoint.Z - BakeHeader.MinZ) / BakeHeader.HeightScale), 0, FBigNoobHeightTileSample::EmptyHeight - 1);
+							BigNoobHeightTiles::EncodeNormal(Hit.ImpactNormal, Sample.NormalU, Sample.NormalV);
+							bAnyGround = true;
+							++Layer;
+						}
+						TopZ = Hit.ImpactPoint.Z - LayerSeparation;
+					}
+				}
+			}
+
+			if (bAnyGround)
+			{
+				Offsets[TileY * BakeHeader.NumTilesX + TileX] = Writer->Tell();
+				Writer->Serialize(BakedSamples.GetData(), BakedSamples.Num() * sizeof(FBigNoobHeightTileSample));
+			}
+		}
+	}
+
+	Writer->Seek(sizeof(BakeHeader));
+	Writer->Serialize(Offsets.GetData(), Offsets.Num() * sizeof(uint64));
+	const bool bSuccess = Writer->Close();
+
+	UE_LOG(LogTemp, Log, TEXT("Baked %dx%d ground height tiles to %s"), BakeHeader.NumTilesX, BakeHeader.NumTilesY, *FullPath);
+	return bSuccess;
+}
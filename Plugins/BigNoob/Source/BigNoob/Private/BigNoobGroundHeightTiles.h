@@ -0,0 +1,96 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class UWorld;
+struct FBigNoobHeightTileBakeSettings;
+
+/**
+*	On-disk layout of a baked ground height tile set (.bnht).
+*
+*	Header, then one uint64 file offset per tile (0 for tiles without any ground), then the tile blobs.
+*	Each tile stores NumLayers x TileResolution x TileResolution samples, layer-major, top layer first.
+*	Sample (i, j) sits at Origin + (i, j) * CellSize in world XY.
+*/
+struct FBigNoobHeightTileHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x54484E42; // "BNHT"
+	static constexpr uint32 ExpectedVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = ExpectedVersion;
+	double OriginX = 0.0;
+	double OriginY = 0.0;
+	float CellSize = 0.0f;
+	float MinZ = 0.0f;
+	float HeightScale = 0.0f;
+	int32 TileResolution = 0;
+	int32 NumTilesX = 0;
+	int32 NumTilesY = 0;
+	int32 NumLayers = 0;
+	uint32 Padding = 0;
+};
+static_assert(sizeof(FBigNoobHeightTileHeader) == 56, "Height tile header layout is part of the file format");
+
+/** One ground sample: quantised height and an octahedral-encoded normal. */
+struct FBigNoobHeightTileSample
+{
+	static constexpr uint16 EmptyHeight = 0xFFFF;
+
+	uint16 Height = EmptyHeight;
+	uint8 NormalU = 0;
+	uint8 NormalV = 0;
+
+	bool IsEmpty() const { return Height == EmptyHeight; }
+};
+static_assert(sizeof(FBigNoobHeightTileSample) == 4, "Height tile sample layout is part of the file format");
+
+/**
+*	Read-only view of a baked height tile file.
+*	The file is memory-mapped and each tile is paged in the first time a lookup touches it.
+*	Lookups are bilinear and lock-free once a tile is mapped, so they can run on any thread.
+*/
+class FBigNoobGroundHeightTiles
+{
+public:
+	~FBigNoobGroundHeightTiles();
+
+	/** Opens Filename, sharing the mapping with other callers that opened the same file. */
+	static TSharedPtr<const FBigNoobGroundHeightTiles, ESPMode::ThreadSafe> FindOrOpen(const FString& Filename);
+
+	/** Drops every shared mapping, tiles still referenced elsewhere stay mapped until released. */
+	static void ResetOpenFiles();
+
+	/**
+	*	Samples the highest baked ground layer at or below MaxZ under (X, Y).
+	*	Returns false when there is no ground above MinZ at that location.
+	*/
+	bool Sample(double X, double Y, double MaxZ, double MinZ, FVector& OutPoint, FVector& OutNormal) const;
+
+	/** Samples the level under Bounds and writes a tile set to Filename. */
+	static bool Bake(UWorld* World, const FBox& Bounds, const FBigNoobHeightTileBakeSettings& Settings, const FString& Filename);
+
+private:
+	FBigNoobGroundHeightTiles() = default;
+
+	bool Open(const FString& Filename);
+	const FBigNoobHeightTileSample* FindSample(int32 SampleX, int32 SampleY, double MaxZ) const;
+	const FBigNoobHeightTileSample* GetTileSamples(int32 TileIndex) const;
+
+	FBigNoobHeightTileHeader Header;
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> TableRegion;
+	const uint64* TileOffsets = nullptr;
+	int64 TileBytes = 0;
+
+	mutable FCriticalSection MapLock;
+	mutable TArray<TUniquePtr<IMappedFileRegion>> TileRegions;
+	mutable TUniquePtr<std::atomic<const FBigNoobHeightTileSample*>[]> TileSamples;
+};
+
+using FBigNoobGroundHeightTilesPtr = TSharedPtr<const FBigNoobGroundHeightTiles, ESPMode::ThreadSafe>;
@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobGroundMeshCache.h"
+#include "BigNoob.h"
+#include "Engine/HitResult.h"
+#include "Engine/StaticMesh.h"
+#include "Misc/ScopeRWLock.h"
+#include "StaticMeshResources.h"
+
+using namespace UE::Geometry;
+
+bool FBigNoobGroundMesh::Build(const UStaticMesh& StaticMesh, int32 LODIndex)
+{
+	const FStaticMeshRenderData* RenderData = StaticMesh.GetRenderData();
+	if (RenderData == nullptr || !RenderData->LODResources.IsValidIndex(LODIndex))
+	{
+		return false;
+	}
+
+	const FStaticMeshLODResources& LOD = RenderData->LODResources[LODIndex];
+	const FPositionVertexBuffer& Positions = LOD.VertexBuffers.PositionVertexBuffer;
+	const FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+
+	// Cooked meshes only keep CPU copies of their buffers when bAllowCPUAccess is set
+	if (Positions.GetVertexData() == nullptr || Indices.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s LOD %d has no CPU geometry, enable Allow CPU Access to use it as cached ground."), *StaticMesh.GetName(), LODIndex);
+		return false;
+	}
+
+	const int32 NumVertices = Positions.GetNumVertices();
+	Mesh.Clear();
+	for (int32 i = 0; i < NumVertices; ++i)
+	{
+		Mesh.AppendVertex(FVector3d(Positions.VertexPosition(i)));
+	}
+
+	for (int32 i = 0; i + 2 < Indices.Num(); i += 3)
+	{
+		const int32 A = Indices[i];
+		const int32 B = Indices[i + 1];
+		const int32 C = Indices[i + 2];
+		if (Mesh.AppendTriangle(A, B, C) < 0)
+		{
+			// Render meshes are not always manifold, give rejected triangles their own vertices so none are lost
+			const int32 A2 = Mesh.AppendVertex(Mesh.GetVertex(A));
+			const int32 B2 = Mesh.AppendVertex(Mesh.GetVertex(B));
+			const int32 C2 = Mesh.AppendVertex(Mesh.GetVertex(C));
+			Mesh.AppendTriangle(A2, B2, C2);
+		}
+	}
+
+	Tree.SetMesh(&Mesh, true);
+	SourceRenderData = RenderData;
+	return Mesh.TriangleCount() > 0;
+}
+
+bool FBigNoobGroundMesh::Raycast(const FTransform& MeshToWorld, const FVector& Start, const FVector& End, FHitResult& OutHit) const
+{
+	const FVector LocalStart = MeshToWorld.InverseTransformPosition(Start);
+	const FVector LocalEnd = MeshToWorld.InverseTransformPosition(End);
+	const FVector LocalDelta = LocalEnd - LocalStart;
+	const double LocalLength = LocalDelta.Size();
+	if (LocalLength <= UE_DOUBLE_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	const FRay3d Ray(LocalStart, LocalDelta / LocalLength, true);
+	IMeshSpatial::FQueryOptions QueryOptions;
+	QueryOptions.MaxDistance = LocalLength;
+
+	double HitT = 0.0;
+	int32 HitTID = IndexConstants::InvalidID;
+	if (!Tree.FindNearestHitTriangle(Ray, HitT, HitTID, QueryOptions))
+	{
+		return false;
+	}
+
+	MakeHitResult(MeshToWorld, Start, End, HitT / LocalLength, HitTID, OutHit);
+	return true;
+}
+
+void FBigNoobGroundMesh::MakeHitResult(const FTransform& MeshToWorld, const FVector& Start, const FVector& End, double Time, int32 TriangleID, FHitResult& OutHit) const
+{
+	// Normals go through the inverse transpose, which for a TRS transform is rotation * (1 / scale)
+	const FVector LocalNormal = Mesh.GetTriNormal(TriangleID);
+	const FVector Scale = MeshToWorld.GetScale3D();
+	const FVector SafeScale(
+		FMath::IsNearlyZero(Scale.X) ? 1.0 : Scale.X,
+		FMath::IsNearlyZero(Scale.Y) ? 1.0 : Scale.Y,
+		FMath::IsNearlyZero(Scale.Z) ? 1.0 : Scale.Z);
+	FVector WorldNormal = MeshToWorld.GetRotation().RotateVector(LocalNormal / SafeScale).GetSafeNormal();
+
+	// Ground is always approached from above, report the side the probe came from
+	if (FVector::DotProduct(WorldNormal, End - Start) > 0.0)
+	{
+		WorldNormal = -WorldNormal;
+	}
+
+	OutHit = FHitResult(Start, End);
+	OutHit.bBlockingHit = true;
+	OutHit.Time = Time;
+	OutHit.Location = OutHit.ImpactPoint = FMath::Lerp(Start, End, Time);
+	OutHit.Normal = OutHit.ImpactNormal = WorldNormal;
+	OutHit.Distance = FVector::Distance(Start, OutHit.ImpactPoint);
+	OutHit.FaceIndex = TriangleID;
+}
+
+FBigNoobGroundMeshCache& FBigNoobGroundMeshCache::Get()
+{
+	static FBigNoobGroundMeshCache Instance;
+	return Instance;
+}
+
+FBigNoobGroundMeshPtr FBigNoobGroundMeshCache::FindOrBuild(const UStaticMesh* StaticMesh, int32 LODIndex)
+{
+	check(IsInGameThread());
+	LLM_SCOPE_BYTAG(BigNoob);
+
+	if (StaticMesh == nullptr)
+	{
+		return nullptr;
+	}
+
+	const FKey Key(StaticMesh, LODIndex);
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const FBigNoobGroundMeshPtr* Found = Entries.Find(Key))
+		{
+			if ((*Found)->SourceRenderData == StaticMesh->GetRenderData())
+			{
+				return *Found;
+			}
+		}
+	}
+
+	TSharedRef<FBigNoobGroundMesh, ESPMode::ThreadSafe> NewMesh = MakeShared<FBigNoobGroundMesh, ESPMode::ThreadSafe>();
+	if (!NewMesh->Build(*StaticMesh, LODIndex))
+	{
+		return nullptr;
+	}
+
+	// Trees that are still in use by an in-flight job stay alive through their shared pointer
+	FWriteScopeLock WriteLock(Lock);
+	Entries.Add(Key, NewMesh);
+	return NewMesh;
+}
+
+void FBigNoobGroundMeshCache::Reset()
+{
+	FWriteScopeLock WriteLock(Lock);
+	Entries.Reset();
+}
@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/DynamicMeshAABBTree3.h"
+#include "UObject/ObjectKey.h"
+
+class UStaticMesh;
+struct FHitResult;
+
+/**
+*	Triangle BVH over one LOD of a ground static mesh, built in mesh local space.
+*	Immutable once built, so any number of threads can raycast it without touching the physics scene.
+*/
+class FBigNoobGroundMesh
+{
+public:
+	FBigNoobGroundMesh() = default;
+	FBigNoobGroundMesh(const FBigNoobGroundMesh&) = delete;
+	FBigNoobGroundMesh& operator=(const FBigNoobGroundMesh&) = delete;
+
+	/** Raycasts the segment Start -> End (world space) against the mesh placed at MeshToWorld. */
+	bool Raycast(const FTransform& MeshToWorld, const FVector& Start, const FVector& End, FHitResult& OutHit) const;
+
+	/** Fills OutHit for a hit at Time along Start -> End on the given triangle. */
+	void MakeHitResult(const FTransform& MeshToWorld, const FVector& Start, const FVector& End, double Time, int32 TriangleID, FHitResult& OutHit) const;
+
+	const UE::Geometry::FDynamicMesh3& GetMesh() const { return Mesh; }
+	const UE::Geometry::FDynamicMeshAABBTree3& GetTree() const { return Tree; }
+
+private:
+	friend class FBigNoobGroundMeshCache;
+
+	bool Build(const UStaticMesh& StaticMesh, int32 LODIndex);
+
+	UE::Geometry::FDynamicMesh3 Mesh;
+	UE::Geometry::FDynamicMeshAABBTree3 Tree;
+
+	/** Render data the tree was built from, used to notice rebuilds and reimports */
+	const void* SourceRenderData = nullptr;
+};
+
+using FBigNoobGroundMeshPtr = TSharedPtr<const FBigNoobGroundMesh, ESPMode::ThreadSafe>;
+
+/** Builds ground BVHs once per (mesh, LOD) and shares them between alignment calls. */
+class FBigNoobGroundMeshCache
+{
+public:
+	static FBigNoobGroundMeshCache& Get();
+
+	/** Must be called on the game thread, the returned tree can then be used from any thread. */
+	FBigNoobGroundMeshPtr FindOrBuild(const UStaticMesh* StaticMesh, int32 LODIndex);
+
+	void Reset();
+
+private:
+	using FKey = TPair<TObjectKey<UStaticMesh>, int32>;
+
+	FRWLock Lock;
+	TMap<FKey, FBigNoobGroundMeshPtr> Entries;
+};
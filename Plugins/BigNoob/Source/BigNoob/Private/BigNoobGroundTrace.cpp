@@ -0,0 +1,193 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobGroundTrace.h"
+#include "BigNoobAlignTypes.h"
+#include "BigNoobRayPacket.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+
+FBigNoobGroundTracer::FBigNoobGroundTracer(UWorld* InWorld, const FBigNoobAlignOptions& InOptions)
+	: World(InWorld)
+	, TraceChannel(InOptions.TraceChannel)
+	, QueryParams(SCENE_QUERY_STAT(BigNoobGroundProbe), false)
+	, RayPacketWidth((int32)InOptions.RayPacketWidth)
+{
+	for (UPrimitiveComponent* Ground : InOptions.GroundComponents)
+	{
+		if (Ground && Ground->IsRegistered())
+		{
+			FBigNoobGroundMeshPtr CachedMesh;
+			const UStaticMeshComponent* GroundMesh = Cast<UStaticMeshComponent>(Ground);
+			if (InOptions.bUseGroundMeshCache && GroundMesh)
+			{
+				CachedMesh = FBigNoobGroundMeshCache::Get().FindOrBuild(GroundMesh->GetStaticMesh(), InOptions.GroundMeshLOD);
+			}
+
+			// The cached BVH is in mesh space, so instanced ground needs one primitive per instance
+			const UInstancedStaticMeshComponent* GroundInstances = Cast<UInstancedStaticMeshComponent>(Ground);
+			if (CachedMesh.IsValid() && GroundInstances)
+			{
+				const FBox MeshBox = GroundInstances->GetStaticMesh()->GetBounds().GetBox();
+				for (int32 InstanceIndex = 0; InstanceIndex < GroundInstances->GetInstanceCount(); ++InstanceIndex)
+				{
+					FTransform InstanceTransform;
+					GroundInstances->GetInstanceTransform(InstanceIndex, InstanceTransform, true);
+					GroundPrimitives.Add({ Ground, MeshBox.TransformBy(InstanceTransform), InstanceTransform, CachedMesh, InstanceIndex });
+				}
+			}
+			else
+			{
+				GroundPrimitives.Add({ Ground, Ground->Bounds.GetBox(), Ground->GetComponentTransform(), MoveTemp(CachedMesh) });
+			}
+		}
+	}
+
+	bThreadSafe = GroundPrimitives.Num() > 0;
+	for (const FGroundPrimitive& Ground : GroundPrimitives)
+	{
+		bThreadSafe &= Ground.CachedMesh.IsValid();
+	}
+
+	if (!InOptions.GroundHeightTiles.FilePath.IsEmpty())
+	{
+		HeightTiles = FBigNoobGroundHeightTiles::FindOrOpen(InOptions.GroundHeightTiles.FilePath);
+		bThreadSafe |= HeightTiles.IsValid();
+	}
+}
+
+bool FBigNoobGroundTracer::TraceProbe(const FVector& Start, const FVector& End, FHitResult& OutHit, const AActor* IgnoredActor) const
+{
+	if (IgnoredActor == nullptr)
+	{
+		return TraceProbeWithParams(Start, End, OutHit, QueryParams);
+	}
+
+	FCollisionQueryParams ActorParams = QueryParams;
+	ActorParams.AddIgnoredActor(IgnoredActor);
+	return TraceProbeWithParams(Start, End, OutHit, ActorParams);
+}
+
+bool FBigNoobGroundTracer::TraceProbeWithParams(const FVector& Start, const FVector& End, FHitResult& OutHit, const FCollisionQueryParams& Params) const
+{
+	if (HeightTiles.IsValid())
+	{
+		return SampleHeightTiles(Start, End, OutHit);
+	}
+
+	if (GroundPrimitives.Num() > 0)
+	{
+		return TraceGroundComponents(Start, End, OutHit);
+	}
+
+	return World && World->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, Params);
+}
+
+void FBigNoobGroundTracer::TraceProbes(TArrayView<const FVector> Starts, TArrayView<const FVector> Ends, TArrayView<FHitResult> OutHits, TArrayView<bool> bOutHits,
+	const AActor* IgnoredActor) const
+{
+	check(Starts.Num() == Ends.Num() && Starts.Num() == OutHits.Num() && Starts.Num() == bOutHits.Num());
+
+	if (!bThreadSafe || RayPacketWidth <= 1 || HeightTiles.IsValid())
+	{
+		// One copy of the query params for the whole batch
+		FCollisionQueryParams ActorParams = QueryParams;
+		if (IgnoredActor)
+		{
+			ActorParams.AddIgnoredActor(IgnoredActor);
+		}
+		for (int32 i = 0; i < Starts.Num(); ++i)
+		{
+			bOutHits[i] = TraceProbeWithParams(Starts[i], Ends[i], OutHits[i], ActorParams);
+		}
+		return;
+	}
+
+	for (bool& bHit : bOutHits)
+	{
+		bHit = false;
+	}
+
+	// Instanced ground adds a primitive per instance, most of which are nowhere near this batch
+	FBox ProbeBounds(ForceInit);
+	for (int32 i = 0; i < Starts.Num(); ++i)
+	{
+		ProbeBounds += Starts[i];
+		ProbeBounds += Ends[i];
+	}
+
+	for (const FGroundPrimitive& Ground : GroundPrimitives)
+	{
+		if (!Ground.Bounds.Intersect(ProbeBounds))
+		{
+			continue;
+		}
+
+		RaycastGroundMeshPackets(*Ground.CachedMesh, Ground.Transform, RayPacketWidth, Starts, Ends, OutHits, bOutHits);
+
+		// Hits this primitive won were rebuilt from scratch and have no component yet
+		for (int32 i = 0; i < OutHits.Num(); ++i)
+		{
+			if (bOutHits[i] && OutHits[i].Component.IsExplicitlyNull())
+			{
+				OutHits[i].Component = Ground.Component;
+				OutHits[i].Item = Ground.InstanceIndex;
+			}
+		}
+	}
+}
+
+bool FBigNoobGroundTracer::TraceGroundComponents(const FVector& Start, const FVector& End, FHitResult& OutHit) const
+{
+	const FVector StartToEnd = End - Start;
+
+	bool bAnyHit = false;
+	for (const FGroundPrimitive& Ground : GroundPrimitives)
+	{
+		// Cheap reject before asking the physics body, most probes only cross one ground primitive
+		if (!FMath::LineBoxIntersection(Ground.Bounds, Start, End, StartToEnd))
+		{
+			continue;
+		}
+
+		// LineTraceComponent tests the body directly, so channel responses do not apply here
+		FHitResult Hit;
+		const bool bHit = Ground.CachedMesh.IsValid()
+			? Ground.CachedMesh->Raycast(Ground.Transform, Start, End, Hit)
+			: Ground.Component->LineTraceComponent(Hit, Start, End, QueryParams);
+
+		if (bHit)
+		{
+			Hit.Component = Ground.Component;
+			if (Ground.InstanceIndex != INDEX_NONE)
+			{
+				Hit.Item = Ground.InstanceIndex;
+			}
+			if (!bAnyHit || Hit.Time < OutHit.Time)
+			{
+				OutHit = Hit;
+				bAnyHit = true;
+			}
+		}
+	}
+
+	return bAnyHit;
+}
+
+bool FBigNoobGroundTracer::SampleHeightTiles(const FVector& Start, const FVector& End, FHitResult& OutHit) const
+{
+	// Tiles store heights only, so probes are treated as vertical rays under their start point
+	FVector Point;
+	FVector Normal;
+	if (!HeightTiles->Sample(Start.X, Start.Y, FMath::Max(Start.Z, End.Z), FMath::Min(Start.Z, End.Z), Point, Normal))
+	{
+		return false;
+	}
+
+	OutHit = FHitResult(Start, End);
+	OutHit.bBlockingHit = true;
+	OutHit.Location = OutHit.ImpactPoint = Point;
+	OutHit.Normal = OutHit.ImpactNormal = Normal;
+	OutHit.Distance = FVector::Distance(Start, Point);
+	OutHit.Time = FMath::Abs(End.Z - Start.Z) > UE_SMALL_NUMBER ? (Start.Z - Point.Z) / (Start.Z - End.Z) : 0.0;
+	return true;
+}
@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Engine/EngineTypes.h"
+#include "BigNoobGroundHeightTiles.h"
+#include "BigNoobGroundMeshCache.h"
+
+class AActor;
+class UPrimitiveComponent;
+class UWorld;
+struct FBigNoobAlignOptions;
+
+/**
+*	Traces alignment probes against the ground.
+*	Probes either go through the world broadphase or, when the options name explicit ground components,
+*	straight to those primitives so the cost only depends on the target geometry.
+*	Baked height tiles take precedence over both and turn every probe into a lookup.
+*/
+class FBigNoobGroundTracer
+{
+public:
+	FBigNoobGroundTracer(UWorld* InWorld, const FBigNoobAlignOptions& InOptions);
+
+	/**
+	*	Returns the closest blocking hit between Start and End.
+	*	World traces pass through IgnoredActor, the actor being aligned, one tracer serves every actor of a batch.
+	*/
+	bool TraceProbe(const FVector& Start, const FVector& End, FHitResult& OutHit, const AActor* IgnoredActor = nullptr) const;
+
+	/** Traces many probes at once, packet tracing them when the ground is fully cached. */
+	void TraceProbes(TArrayView<const FVector> Starts, TArrayView<const FVector> Ends, TArrayView<FHitResult> OutHits, TArrayView<bool> bOutHits,
+		const AActor* IgnoredActor = nullptr) const;
+
+	bool HasGroundComponents() const { return GroundPrimitives.Num() > 0; }
+
+	/** True when every probe is answered by cached BVHs or height tiles, so TraceProbe may be called from worker threads. */
+	bool IsThreadSafe() const { return bThreadSafe; }
+
+private:
+	bool TraceProbeWithParams(const FVector& Start, const FVector& End, FHitResult& OutHit, const FCollisionQueryParams& Params) const;
+	bool TraceGroundComponents(const FVector& Start, const FVector& End, FHitResult& OutHit) const;
+	bool SampleHeightTiles(const FVector& Start, const FVector& End, FHitResult& OutHit) const;
+
+	struct FGroundPrimitive
+	{
+		UPrimitiveComponent* Component;
+		FBox Bounds;
+		FTransform Transform;
+		FBigNoobGroundMeshPtr CachedMesh;
+		int32 InstanceIndex = INDEX_NONE; // Instance of instanced ground, Transform is then the instance's
+	};
+
+	UWorld* World;
+	ECollisionChannel TraceChannel;
+	FCollisionQueryParams QueryParams;
+	TArray<FGroundPrimitive, TInlineAllocator<4>> GroundPrimitives;
+	FBigNoobGroundHeightTilesPtr HeightTiles;
+	bool bThreadSafe = false;
+	int32 RayPacketWidth = 1;
+};
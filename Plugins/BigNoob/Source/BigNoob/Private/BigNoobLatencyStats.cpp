@@ -0,0 +1,148 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobLatencyStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/OutputDevice.h"
+
+FBigNoobLatencyHistogram::FBigNoobLatencyHistogram()
+{
+	Reset();
+}
+
+int32 FBigNoobLatencyHistogram::GetBucket(uint64 Micros)
+{
+	if (Micros < SubBuckets)
+	{
+		return (int32)Micros;
+	}
+
+	// The top bits below the leading one pick the sub-bucket within the power of two
+	const int32 Log2 = (int32)FMath::FloorLog2_64(Micros);
+	const int32 SubBucket = (int32)((Micros >> (Log2 - 3)) & (SubBuckets - 1));
+	return FMath::Min((Log2 - 2) * SubBuckets + SubBucket, NumBuckets - 1);
+}
+
+double FBigNoobLatencyHistogram::GetBucketUpperSeconds(int32 Bucket)
+{
+	if (Bucket < SubBuckets)
+	{
+		return (Bucket + 1) * 1e-6;
+	}
+
+	const int32 Log2 = Bucket / SubBuckets + 2;
+	const uint64 Lower = (uint64(SubBuckets) + Bucket % SubBuckets) << (Log2 - 3);
+	return (Lower + (uint64(1) << (Log2 - 3))) * 1e-6;
+}
+
+void FBigNoobLatencyHistogram::Record(double Seconds)
+{
+	const uint64 Micros = (uint64)FMath::Max(Seconds * 1e6, 0.0);
+	Buckets[GetBucket(Micros)].fetch_add(1, std::memory_order_relaxed);
+	Count.fetch_add(1, std::memory_order_relaxed);
+
+	uint64 Max = MaxMicros.load(std::memory_order_relaxed);
+	while (Micros > Max && !MaxMicros.compare_exchange_weak(Max, Micros, std::memory_order_relaxed))
+	{
+	}
+}
+
+void FBigNoobLatencyHistogram::Reset()
+{
+	for (std::atomic<int64>& Bucket : Buckets)
+	{
+		Bucket.store(0, std::memory_order_relaxed);
+	}
+	Count.store(0, std::memory_order_relaxed);
+	MaxMicros.store(0, std::memory_order_relaxed);
+}
+
+double FBigNoobLatencyHistogram::GetPercentile(double Fraction) const
+{
+	// Recorders may still be adding, so the total is taken from the buckets actually read
+	int64 Snapshot[NumBuckets];
+	int64 Total = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Snapshot[Bucket] = Buckets[Bucket].load(std::memory_order_relaxed);
+		Total += Snapshot[Bucket];
+	}
+	if (Total == 0)
+	{
+		return 0.0;
+	}
+
+	const int64 Rank = FMath::Clamp((int64)FMath::CeilToDouble(Fraction * Total), (int64)1, Total);
+	int64 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Snapshot[Bucket];
+		if (Seen >= Rank)
+		{
+			// The bucket's upper edge, but never past the largest sample
+			return FMath::Min(GetBucketUpperSeconds(Bucket), FMath::Max(GetMax(), 1e-6));
+		}
+	}
+	return GetMax();
+}
+
+double FBigNoobLatencyHistogram::GetMax() const
+{
+	return MaxMicros.load(std::memory_order_relaxed) * 1e-6;
+}
+
+FBigNoobLatencyStats& FBigNoobLatencyStats::Get()
+{
+	static FBigNoobLatencyStats Instance;
+	return Instance;
+}
+
+FBigNoobLatencyStats::FBigNoobLatencyStats()
+{
+	Reset();
+}
+
+void FBigNoobLatencyStats::RecordRun(int32 NumJobs, double RunSeconds)
+{
+	Jobs.fetch_add(NumJobs, std::memory_order_relaxed);
+	BusyMicros.fetch_add((uint64)FMath::Max(RunSeconds * 1e6, 0.0), std::memory_order_relaxed);
+}
+
+void FBigNoobLatencyStats::Dump(FOutputDevice& Ar) const
+{
+	static const TCHAR* StageNames[] = { TEXT("Sample"), TEXT("Trace"), TEXT("Fit"), TEXT("Apply") };
+	static_assert(UE_ARRAY_COUNT(StageNames) == (int32)EBigNoobAlignStage::Num, "Every stage needs a name");
+
+	Ar.Logf(TEXT("BigNoob alignment latency per component, in milliseconds:"));
+	for (int32 Stage = 0; Stage < (int32)EBigNoobAlignStage::Num; ++Stage)
+	{
+		const FBigNoobLatencyHistogram& Histogram = Stages[Stage];
+		Ar.Logf(TEXT("  %-6s n=%-8lld p50=%8.3f p90=%8.3f p99=%8.3f max=%8.3f"), StageNames[Stage], Histogram.Num(),
+			Histogram.GetPercentile(0.5) * 1000.0, Histogram.GetPercentile(0.9) * 1000.0, Histogram.GetPercentile(0.99) * 1000.0, Histogram.GetMax() * 1000.0);
+	}
+
+	const int64 NumJobs = Jobs.load(std::memory_order_relaxed);
+	const double BusySeconds = BusyMicros.load(std::memory_order_relaxed) * 1e-6;
+	const double WallSeconds = FPlatformTime::Seconds() - ResetTime.load(std::memory_order_relaxed);
+	Ar.Logf(TEXT("  %lld jobs, %.1f jobs/s while aligning, %.1f jobs/s since the last reset"), NumJobs,
+		BusySeconds > 0.0 ? NumJobs / BusySeconds : 0.0, WallSeconds > 0.0 ? NumJobs / WallSeconds : 0.0);
+}
+
+void FBigNoobLatencyStats::Reset()
+{
+	for (FBigNoobLatencyHistogram& Stage : Stages)
+	{
+		Stage.Reset();
+	}
+	Jobs.store(0, std::memory_order_relaxed);
+	BusyMicros.store(0, std::memory_order_relaxed);
+	ResetTime.store(FPlatformTime::Seconds(), std::memory_order_relaxed);
+}
+
+static FAutoConsoleCommandWithOutputDevice BigNoobStatsCommand(
+	TEXT("BigNoob.Stats"),
+	TEXT("Print p50/p90/p99/max latency of every alignment stage per component and the jobs per second since the last call, then reset them."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FBigNoobLatencyStats::Get().Dump(Ar);
+		FBigNoobLatencyStats::Get().Reset();
+	}));
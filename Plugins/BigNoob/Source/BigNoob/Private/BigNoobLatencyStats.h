@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/** Per-component stages of an alignment run. */
+enum class EBigNoobAlignStage : uint8
+{
+	Sample,	// Laying out the probes
+	Trace,
+	Fit,
+	Apply,
+	Num
+};
+
+/**
+*	Latency histogram that any number of threads can record into without locking.
+*	Buckets are log-linear in microseconds, 8 per power of two, so percentiles are within 12.5% up to a couple of hours.
+*/
+class FBigNoobLatencyHistogram
+{
+public:
+	FBigNoobLatencyHistogram();
+
+	void Record(double Seconds);
+
+	/** Not atomic against concurrent Record calls, a sample recorded meanwhile may be kept or lost. */
+	void Reset();
+
+	int64 Num() const { return Count.load(std::memory_order_relaxed); }
+
+	/** Upper edge of the bucket holding the Fraction quantile, in seconds. Zero when nothing was recorded. */
+	double GetPercentile(double Fraction) const;
+
+	double GetMax() const;
+
+private:
+	static constexpr int32 SubBuckets = 8;
+	static constexpr int32 NumBuckets = 32 * SubBuckets;
+
+	static int32 GetBucket(uint64 Micros);
+	static double GetBucketUpperSeconds(int32 Bucket);
+
+	std::atomic<int64> Buckets[NumBuckets];
+	std::atomic<int64> Count;
+	std::atomic<uint64> MaxMicros;
+};
+
+/**
+*	Process-wide latency of every aligned component, per stage, plus throughput.
+*	Printed and reset by the BigNoob.Stats console command.
+*/
+class FBigNoobLatencyStats
+{
+public:
+	static FBigNoobLatencyStats& Get();
+
+	void RecordStage(EBigNoobAlignStage Stage, double Seconds) { Stages[(int32)Stage].Record(Seconds); }
+
+	/** One finished alignment run, RunSeconds is its wall time. */
+	void RecordRun(int32 NumJobs, double RunSeconds);
+
+	void Dump(FOutputDevice& Ar) const;
+
+	void Reset();
+
+private:
+	FBigNoobLatencyStats();
+
+	FBigNoobLatencyHistogram Stages[(int32)EBigNoobAlignStage::Num];
+	std::atomic<int64> Jobs;
+	std::atomic<uint64> BusyMicros;
+	std::atomic<double> ResetTime;
+};
@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobMeshBasePlane.h"
+#include "BigNoob.h"
+#include "BigNoobPlaneEstimators.h"
+#include "Engine/StaticMesh.h"
+#include "Misc/ScopeLock.h"
+#include "StaticMeshResources.h"
+
+bool ComputeMeshBasePlane(const UStaticMesh& StaticMesh, EBigNoobPlaneEstimator Estimator, FPlane& OutPlane, TArray<FVector>* OutBaseVertices)
+{
+	const FBox LocalBounds = StaticMesh.GetBoundingBox();
+	OutPlane = FPlane(FVector(LocalBounds.GetCenter().X, LocalBounds.GetCenter().Y, LocalBounds.Min.Z), FVector::UpVector);
+
+	const FStaticMeshRenderData* RenderData = StaticMesh.GetRenderData();
+	if (RenderData == nullptr || RenderData->LODResources.Num() == 0)
+	{
+		return false;
+	}
+
+	const FBigNoobPointView Vertices = FBigNoobPointView::FromPositionVertexBuffer(RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer);
+	if (Vertices.Num() < 3)
+	{
+		return false;
+	}
+
+	// The estimators find the top of a point set, so work on the mesh mirrored upside down.
+	// The support facet under the bounds centre is then exactly the face the mesh would rest on.
+	TArray<FVector> Mirrored;
+	Mirrored.Reserve(Vertices.Num());
+	for (int32 i = 0; i < Vertices.Num(); ++i)
+	{
+		const FVector Vertex = Vertices[i];
+		Mirrored.Add(FVector(Vertex.X, Vertex.Y, -Vertex.Z));
+	}
+
+	const FVector MirroredCenter(LocalBounds.GetCenter().X, LocalBounds.GetCenter().Y, -LocalBounds.GetCenter().Z);
+	const FPlane RestingFacet = FindSupportPlane(Mirrored, MirroredCenter);
+	const FVector FacetNormal = RestingFacet.GetSafeNormal() * (RestingFacet.Z < 0.0 ? -1.0 : 1.0);
+
+	// Refit over every vertex lying on that face with the estimator the caller uses for the ground
+	const double BaseBand = FMath::Max(0.01 * LocalBounds.GetSize().GetMax(), 0.5);
+	const double FacetW = RestingFacet.W * (RestingFacet.Z < 0.0 ? -1.0 : 1.0);
+	TArray<FVector> BaseVertices;
+	for (const FVector& Vertex : Mirrored)
+	{
+		if (FacetW - FVector::DotProduct(Vertex, FacetNormal) <= BaseBand)
+		{
+			BaseVertices.Add(Vertex);
+		}
+	}
+
+	const FPlane MirroredBase = BaseVertices.Num() >= 3
+		? FindGroundPlane(BaseVertices, Estimator, MirroredCenter)
+		: FPlane(FacetNormal, FacetW);
+
+	// Mirror back, the normal now points into the mesh, which is its up
+	const FVector MirroredNormal = MirroredBase.GetSafeNormal();
+	const FVector BaseUp(-MirroredNormal.X, -MirroredNormal.Y, MirroredNormal.Z);
+	const FVector MirroredPoint = MirroredNormal * MirroredBase.W;
+	OutPlane = FPlane(FVector(MirroredPoint.X, MirroredPoint.Y, -MirroredPoint.Z), BaseUp);
+
+	if (OutBaseVertices)
+	{
+		OutBaseVertices->Reset(BaseVertices.Num());
+		for (const FVector& Vertex : BaseVertices)
+		{
+			OutBaseVertices->Add(FVector(Vertex.X, Vertex.Y, -Vertex.Z));
+		}
+	}
+	return true;
+}
+
+FBigNoobMeshBasePlaneCache& FBigNoobMeshBasePlaneCache::Get()
+{
+	static FBigNoobMeshBasePlaneCache Instance;
+	return Instance;
+}
+
+FPlane FBigNoobMeshBasePlaneCache::FindOrCompute(const UStaticMesh* StaticMesh, EBigNoobPlaneEstimator Estimator)
+{
+	LLM_SCOPE_BYTAG(BigNoob);
+	if (StaticMesh == nullptr)
+	{
+		return FPlane(FVector::ZeroVector, FVector::UpVector);
+	}
+
+	const FKey Key(StaticMesh, Estimator);
+	const void* RenderData = StaticMesh->GetRenderData();
+
+	FScopeLock ScopeLock(&Lock);
+	if (const FEntry* Found = Entries.Find(Key))
+	{
+		if (Found->SourceRenderData == RenderData)
+		{
+			return Found->Plane;
+		}
+	}
+
+	FPlane Plane;
+	ComputeMeshBasePlane(*StaticMesh, Estimator, Plane);
+	Entries.Add(Key, { Plane, RenderData });
+	return Plane;
+}
+
+void FBigNoobMeshBasePlaneCache::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Reset();
+}
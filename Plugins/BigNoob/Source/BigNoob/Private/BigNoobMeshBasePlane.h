@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BigNoobAlignTypes.h"
+#include "UObject/ObjectKey.h"
+
+class UStaticMesh;
+
+/**
+*	Plane a static mesh rests on, in mesh local space, fitted from its lowest vertices.
+*	The plane's normal is the mesh's own up direction, which is not +Z for meshes whose base is not flat in local space.
+*	Returns false when the mesh has no CPU vertex data, OutPlane is then the bottom of the local bounds.
+*	OutBaseVertices, when given, receives the local space vertices the plane was fitted to.
+*/
+bool ComputeMeshBasePlane(const UStaticMesh& StaticMesh, EBigNoobPlaneEstimator Estimator, FPlane& OutPlane, TArray<FVector>* OutBaseVertices = nullptr);
+
+/** Computes each mesh's base plane once and keeps it until the mesh's render data changes. */
+class FBigNoobMeshBasePlaneCache
+{
+public:
+	static FBigNoobMeshBasePlaneCache& Get();
+
+	/** Game thread only, reads the mesh's vertex buffer on a miss. */
+	FPlane FindOrCompute(const UStaticMesh* StaticMesh, EBigNoobPlaneEstimator Estimator);
+
+	void Reset();
+
+private:
+	struct FEntry
+	{
+		FPlane Plane;
+		const void* SourceRenderData;
+	};
+
+	using FKey = TPair<TObjectKey<UStaticMesh>, EBigNoobPlaneEstimator>;
+
+	FCriticalSection Lock;
+	TMap<FKey, FEntry> Entries;
+};
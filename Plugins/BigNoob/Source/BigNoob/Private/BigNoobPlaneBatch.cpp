@@ -0,0 +1,366 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobPlaneBatch.h"
+#include "BigNoobPlaneEstimators.h"
+#include "Math/VectorRegister.h"
+
+namespace BigNoobPlaneBatch
+{
+	/**
+	*	Symmetric 3x3 matrices and their accumulated Jacobi rotations, one problem per lane, 4 lanes per register.
+	*	Only the upper triangle is kept, the rotations keep the matrix symmetric.
+	*	Doubles, so every lane gives the same answer as SolveSymmetric3x3.
+	*/
+	template<int32 NumRegs>
+	struct TProblems
+	{
+		static constexpr int32 Width = NumRegs * 4;
+
+		VectorRegister4Double A00[NumRegs], A01[NumRegs], A02[NumRegs], A11[NumRegs], A12[NumRegs], A22[NumRegs];
+		VectorRegister4Double V[3][3][NumRegs];
+	};
+
+	/**
+	*	One Jacobi rotation in the (P, Q) plane of every lane, R is the remaining axis.
+	*	Lanes whose APQ is already zero get the identity rotation, so there is no branch on any lane.
+	*/
+	FORCEINLINE void Rotate(
+		VectorRegister4Double& APP, VectorRegister4Double& AQQ, VectorRegister4Double& APQ,
+		VectorRegister4Double& ARP, VectorRegister4Double& ARQ,
+		VectorRegister4Double (&V)[3][3], int32 P, int32 Q)
+	{
+		const VectorRegister4Double Zero = VectorZeroDouble();
+		const VectorRegister4Double One = VectorOneDouble();
+		const VectorRegister4Double Two = VectorSetFloat1(2.0);
+
+		// Same rotation as the scalar solver. An infinite Theta gives T = 0, a NaN one is masked out below.
+		const VectorRegister4Double Theta = VectorDivide(VectorSubtract(AQQ, APP), VectorMultiply(Two, APQ));
+		const VectorRegister4Double Sign = VectorSelect(VectorCompareGE(Theta, Zero), One, VectorNegate(One));
+		const VectorRegister4Double Root = VectorSqrt(VectorMultiplyAdd(Theta, Theta, One));
+		VectorRegister4Double T = VectorDivide(Sign, VectorAdd(VectorAbs(Theta), Root));
+		T = VectorSelect(VectorCompareEQ(APQ, Zero), Zero, T);
+		const VectorRegister4Double C = VectorDivide(One, VectorSqrt(VectorMultiplyAdd(T, T, One)));
+		const VectorRegister4Double S = VectorMultiply(T, C);
+
+		APP = VectorSubtract(APP, VectorMultiply(T, APQ));
+		AQQ = VectorMultiplyAdd(T, APQ, AQQ);
+		APQ = Zero;
+
+		const VectorRegister4Double RP = ARP;
+		const VectorRegister4Double RQ = ARQ;
+		ARP = VectorSubtract(VectorMultiply(C, RP), VectorMultiply(S, RQ));
+		ARQ = VectorMultiplyAdd(S, RP, VectorMultiply(C, RQ));
+
+		for (int32 k = 0; k < 3; ++k)
+		{
+			const VectorRegister4Double VKP = V[k][P];
+			const VectorRegister4Double VKQ = V[k][Q];
+			V[k][P] = VectorSubtract(VectorMultiply(C, VKP), VectorMultiply(S, VKQ));
+			V[k][Q] = VectorMultiplyAdd(S, VKP, VectorMultiply(C, VKQ));
+		}
+	}
+
+	template<int32 NumRegs>
+	void Solve(TProblems<NumRegs>& Problems)
+	{
+		const VectorRegister4Double Tolerance = VectorSetFloat1(1e-24);
+		VectorRegister4Double Scale[NumRegs];
+		for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+		{
+			const VectorRegister4Double Diagonal = VectorMultiplyAdd(Problems.A00[Reg], Problems.A00[Reg],
+				VectorMultiplyAdd(Problems.A11[Reg], Problems.A11[Reg], VectorMultiply(Problems.A22[Reg], Problems.A22[Reg])));
+			const VectorRegister4Double OffDiagonal = VectorMultiplyAdd(Problems.A01[Reg], Problems.A01[Reg],
+				VectorMultiplyAdd(Problems.A02[Reg], Problems.A02[Reg], VectorMultiply(Problems.A12[Reg], Problems.A12[Reg])));
+			Scale[Reg] = VectorMultiply(Tolerance, VectorMultiplyAdd(VectorSetFloat1(2.0), OffDiagonal, Diagonal));
+		}
+
+		for (int32 Sweep = 0; Sweep < 16; ++Sweep)
+		{
+			// Every lane keeps sweeping until the slowest one has converged, extra sweeps leave a diagonal matrix alone
+			bool bConverged = true;
+			for (int32 Reg = 0; Reg < NumRegs && bConverged; ++Reg)
+			{
+				const VectorRegister4Double OffDiagonal = VectorMultiplyAdd(Problems.A01[Reg], Problems.A01[Reg],
+					VectorMultiplyAdd(Problems.A02[Reg], Problems.A02[Reg], VectorMultiply(Problems.A12[Reg], Problems.A12[Reg])));
+				bConverged = VectorMaskBits(VectorCompareLE(OffDiagonal, Scale[Reg])) == 0xF;
+			}
+			if (bConverged)
+			{
+				break;
+			}
+
+			for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+			{
+				VectorRegister4Double V[3][3];
+				for (int32 Row = 0; Row < 3; ++Row)
+				{
+					for (int32 Column = 0; Column < 3; ++Column)
+					{
+						V[Row][Column] = Problems.V[Row][Column][Reg];
+					}
+				}
+
+				// A[2][0] and A[2][1] are the symmetric A02 and A12, and so on for the other pairs
+				Rotate(Problems.A00[Reg], Problems.A11[Reg], Problems.A01[Reg], Problems.A02[Reg], Problems.A12[Reg], V, 0, 1);
+				Rotate(Problems.A00[Reg], Problems.A22[Reg], Problems.A02[Reg], Problems.A01[Reg], Problems.A12[Reg], V, 0, 2);
+				Rotate(Problems.A11[Reg], Problems.A22[Reg], Problems.A12[Reg], Problems.A01[Reg], Problems.A02[Reg], V, 1, 2);
+
+				for (int32 Row = 0; Row < 3; ++Row)
+				{
+					for (int32 Column = 0; Column < 3; ++Column)
+					{
+						Problems.V[Row][Column][Reg] = V[Row][Column];
+					}
+				}
+			}
+		}
+	}
+
+	template<int32 NumRegs>
+	void FitPlanes(TArrayView<const FBigNoobPlaneAccumulator* const> Accumulators, TArrayView<FPlane> OutPlanes, TArrayView<bool> bOutValid)
+	{
+		constexpr int32 Width = TProblems<NumRegs>::Width;
+		TProblems<NumRegs> Problems;
+
+		for (int32 First = 0; First < Accumulators.Num(); First += Width)
+		{
+			const int32 Count = FMath::Min(Width, Accumulators.Num() - First);
+			alignas(32) double Lanes[6][Width];
+			FVector Centroids[Width];
+			bool bHasMoments[Width];
+			for (int32 Lane = 0; Lane < Width; ++Lane)
+			{
+				// Padding lanes and lanes with too few points solve the identity, which converges immediately
+				double Covariance[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+				bHasMoments[Lane] = Lane < Count && Accumulators[First + Lane]->GetMoments(Centroids[Lane], Covariance);
+				Lanes[0][Lane] = Covariance[0][0];
+				Lanes[1][Lane] = Covariance[0][1];
+				Lanes[2][Lane] = Covariance[0][2];
+				Lanes[3][Lane] = Covariance[1][1];
+				Lanes[4][Lane] = Covariance[1][2];
+				Lanes[5][Lane] = Covariance[2][2];
+			}
+
+			for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+			{
+				const int32 Offset = Reg * 4;
+				Problems.A00[Reg] = VectorLoadAligned(Lanes[0] + Offset);
+				Problems.A01[Reg] = VectorLoadAligned(Lanes[1] + Offset);
+				Problems.A02[Reg] = VectorLoadAligned(Lanes[2] + Offset);
+				Problems.A11[Reg] = VectorLoadAligned(Lanes[3] + Offset);
+				Problems.A12[Reg] = VectorLoadAligned(Lanes[4] + Offset);
+				Problems.A22[Reg] = VectorLoadAligned(Lanes[5] + Offset);
+				for (int32 Row = 0; Row < 3; ++Row)
+				{
+					for (int32 Column = 0; Column < 3; ++Column)
+					{
+						Problems.V[Row][Column][Reg] = Row == Column ? VectorOneDouble() : VectorZeroDouble();
+					}
+				}
+			}
+
+			Solve(Problems);
+
+			alignas(32) double Eigenvalues[3][Width];
+			alignas(32) double Eigenvectors[3][3][Width];
+			for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+			{
+				const int32 Offset = Reg * 4;
+				VectorStoreAligned(Problems.A00[Reg], Eigenvalues[0] + Offset);
+				VectorStoreAligned(Problems.A11[Reg], Eigenvalues[1] + Offset);
+				VectorStoreAligned(Problems.A22[Reg], Eigenvalues[2] + Offset);
+				for (int32 Row = 0; Row < 3; ++Row)
+				{
+					for (int32 Column = 0; Column < 3; ++Column)
+					{
+						VectorStoreAligned(Problems.V[Row][Column][Reg], Eigenvectors[Row][Column] + Offset);
+					}
+				}
+			}
+
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				const int32 Index = First + Lane;
+				const double E0 = Eigenvalues[0][Lane];
+				const double E1 = Eigenvalues[1][Lane];
+				const double E2 = Eigenvalues[2][Lane];
+				const int32 Smallest = E0 <= E1 ? (E0 <= E2 ? 0 : 2) : (E1 <= E2 ? 1 : 2);
+				const double Largest = FMath::Max3(E0, E1, E2);
+				const double Middle = E0 + E1 + E2 - Largest - Eigenvalues[Smallest][Lane];
+
+				// Collinear points span no plane, same test as FBigNoobPlaneAccumulator
+				bOutValid[Index] = bHasMoments[Lane] && Middle > UE_DOUBLE_SMALL_NUMBER * FMath::Max(Largest, 1.0);
+				if (bOutValid[Index])
+				{
+					const FVector Normal(Eigenvectors[0][Smallest][Lane], Eigenvectors[1][Smallest][Lane], Eigenvectors[2][Smallest][Lane]);
+					OutPlanes[Index] = FPlane(Centroids[Lane], Normal);
+				}
+				else
+				{
+					OutPlanes[Index] = FPlane(Accumulators[Index]->Num() > 0 ? Accumulators[Index]->GetCentroid() : FVector::ZeroVector, FVector::UpVector);
+				}
+			}
+		}
+	}
+
+	/**
+	*	Yaw-preserving ground rotations of one register of lanes.
+	*	The yaw's half angle comes from the heading's cosine and sine without any trigonometry, the tilt is the
+	*	shortest arc from the yawed base normal to the ground normal. Opposite normals take the same half turn
+	*	FQuat::FindBetweenNormals picks, by select, so near-vertical normals need no branch.
+	*/
+	FORCEINLINE void LanesQuatFromPlane(
+		const VectorRegister4Double (&N)[3], const VectorRegister4Double (&Q)[4], const VectorRegister4Double (&L)[3],
+		VectorRegister4Double (&OutQ)[4])
+	{
+		const VectorRegister4Double Zero = VectorZeroDouble();
+		const VectorRegister4Double One = VectorOneDouble();
+		const VectorRegister4Double Half = VectorSetFloat1(0.5);
+		const VectorRegister4Double Two = VectorSetFloat1(2.0);
+		const VectorRegister4Double Tiny = VectorSetFloat1(UE_SMALL_NUMBER);
+
+		// Heading of the current rotation's forward axis, the same atan2 inputs FQuat::Rotator reads its yaw from
+		const VectorRegister4Double YawY = VectorMultiply(Two, VectorMultiplyAdd(Q[3], Q[2], VectorMultiply(Q[0], Q[1])));
+		const VectorRegister4Double YawX = VectorSubtract(One, VectorMultiply(Two, VectorMultiplyAdd(Q[1], Q[1], VectorMultiply(Q[2], Q[2]))));
+		const VectorRegister4Double HeadingSq = VectorMultiplyAdd(YawX, YawX, VectorMultiply(YawY, YawY));
+		const VectorRegister4Double bHeading = VectorCompareGT(HeadingSq, Tiny);
+		const VectorRegister4Double InvHeading = VectorDivide(One, VectorSqrt(VectorSelect(bHeading, HeadingSq, One)));
+		const VectorRegister4Double Cos = VectorSelect(bHeading, VectorMultiply(YawX, InvHeading), One);
+		const VectorRegister4Double Sin = VectorSelect(bHeading, VectorMultiply(YawY, InvHeading), Zero);
+
+		const VectorRegister4Double YawW = VectorSqrt(VectorMax(VectorMultiply(VectorAdd(One, Cos), Half), Zero));
+		const VectorRegister4Double YawZAbs = VectorSqrt(VectorMax(VectorMultiply(VectorSubtract(One, Cos), Half), Zero));
+		const VectorRegister4Double YawZ = VectorSelect(VectorCompareGE(Sin, Zero), YawZAbs, VectorNegate(YawZAbs));
+
+		// Base normal turned by the yaw
+		const VectorRegister4Double BX = VectorSubtract(VectorMultiply(Cos, L[0]), VectorMultiply(Sin, L[1]));
+		const VectorRegister4Double BY = VectorMultiplyAdd(Sin, L[0], VectorMultiply(Cos, L[1]));
+		const VectorRegister4Double BZ = L[2];
+
+		// Ground normal, a zero one leaves the tilt at identity like GetSafeNormal's zero vector did
+		const VectorRegister4Double NormalSq = VectorMultiplyAdd(N[0], N[0], VectorMultiplyAdd(N[1], N[1], VectorMultiply(N[2], N[2])));
+		const VectorRegister4Double bNormal = VectorCompareGT(NormalSq, Tiny);
+		const VectorRegister4Double InvNormal = VectorDivide(One, VectorSqrt(VectorSelect(bNormal, NormalSq, One)));
+		const VectorRegister4Double NX = VectorSelect(bNormal, VectorMultiply(N[0], InvNormal), BX);
+		const VectorRegister4Double NY = VectorSelect(bNormal, VectorMultiply(N[1], InvNormal), BY);
+		const VectorRegister4Double NZ = VectorSelect(bNormal, VectorMultiply(N[2], InvNormal), BZ);
+
+		// Shortest arc (B x N, 1 + B.N), or a half turn about an axis perpendicular to B when they are opposite
+		const VectorRegister4Double W = VectorAdd(One, VectorMultiplyAdd(BX, NX, VectorMultiplyAdd(BY, NY, VectorMultiply(BZ, NZ))));
+		const VectorRegister4Double bOpposite = VectorCompareLT(W, VectorSetFloat1(1e-6));
+		const VectorRegister4Double bAlongX = VectorCompareGT(VectorAbs(BX), VectorAbs(BY));
+		const VectorRegister4Double HalfTurnX = VectorSelect(bAlongX, VectorNegate(BZ), Zero);
+		const VectorRegister4Double HalfTurnY = VectorSelect(bAlongX, Zero, VectorNegate(BZ));
+		const VectorRegister4Double HalfTurnZ = VectorSelect(bAlongX, BX, BY);
+		VectorRegister4Double TX = VectorSelect(bOpposite, HalfTurnX, VectorSubtract(VectorMultiply(BY, NZ), VectorMultiply(BZ, NY)));
+		VectorRegister4Double TY = VectorSelect(bOpposite, HalfTurnY, VectorSubtract(VectorMultiply(BZ, NX), VectorMultiply(BX, NZ)));
+		VectorRegister4Double TZ = VectorSelect(bOpposite, HalfTurnZ, VectorSubtract(VectorMultiply(BX, NY), VectorMultiply(BY, NX)));
+		VectorRegister4Double TW = VectorSelect(bOpposite, Zero, W);
+		const VectorRegister4Double InvTilt = VectorDivide(One, VectorSqrt(
+			VectorMultiplyAdd(TX, TX, VectorMultiplyAdd(TY, TY, VectorMultiplyAdd(TZ, TZ, VectorMultiply(TW, TW))))));
+		TX = VectorMultiply(TX, InvTilt);
+		TY = VectorMultiply(TY, InvTilt);
+		TZ = VectorMultiply(TZ, InvTilt);
+		TW = VectorMultiply(TW, InvTilt);
+
+		// Tilt * Yaw, with the yaw's X and Y zero
+		OutQ[0] = VectorMultiplyAdd(TX, YawW, VectorMultiply(TY, YawZ));
+		OutQ[1] = VectorSubtract(VectorMultiply(TY, YawW), VectorMultiply(TX, YawZ));
+		OutQ[2] = VectorMultiplyAdd(TW, YawZ, VectorMultiply(TZ, YawW));
+		OutQ[3] = VectorSubtract(VectorMultiply(TW, YawW), VectorMultiply(TZ, YawZ));
+	}
+
+	template<int32 NumRegs>
+	void QuatsFromPlanes(TArrayView<const FPlane> GroundPlanes, TArrayView<const FQuat> CurrentRotations, TArrayView<const FVector> LocalBaseNormals, TArrayView<FQuat> OutRotations)
+	{
+		constexpr int32 Width = NumRegs * 4;
+		for (int32 First = 0; First < GroundPlanes.Num(); First += Width)
+		{
+			const int32 Count = FMath::Min(Width, GroundPlanes.Num() - First);
+			alignas(32) double In[10][Width];
+			for (int32 Lane = 0; Lane < Width; ++Lane)
+			{
+				// Padding lanes repeat the first problem
+				const int32 Index = First + (Lane < Count ? Lane : 0);
+				const FPlane& Plane = GroundPlanes[Index];
+				const FQuat& Rotation = CurrentRotations[Index];
+				const FVector& BaseNormal = LocalBaseNormals[Index];
+				In[0][Lane] = Plane.X;
+				In[1][Lane] = Plane.Y;
+				In[2][Lane] = Plane.Z;
+				In[3][Lane] = Rotation.X;
+				In[4][Lane] = Rotation.Y;
+				In[5][Lane] = Rotation.Z;
+				In[6][Lane] = Rotation.W;
+				In[7][Lane] = BaseNormal.X;
+				In[8][Lane] = BaseNormal.Y;
+				In[9][Lane] = BaseNormal.Z;
+			}
+
+			alignas(32) double Out[4][Width];
+			for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+			{
+				const int32 Offset = Reg * 4;
+				const VectorRegister4Double N[3] = { VectorLoadAligned(In[0] + Offset), VectorLoadAligned(In[1] + Offset), VectorLoadAligned(In[2] + Offset) };
+				const VectorRegister4Double Q[4] = { VectorLoadAligned(In[3] + Offset), VectorLoadAligned(In[4] + Offset), VectorLoadAligned(In[5] + Offset), VectorLoadAligned(In[6] + Offset) };
+				const VectorRegister4Double L[3] = { VectorLoadAligned(In[7] + Offset), VectorLoadAligned(In[8] + Offset), VectorLoadAligned(In[9] + Offset) };
+				VectorRegister4Double Result[4];
+				LanesQuatFromPlane(N, Q, L, Result);
+				for (int32 Component = 0; Component < 4; ++Component)
+				{
+					VectorStoreAligned(Result[Component], Out[Component] + Offset);
+				}
+			}
+
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				OutRotations[First + Lane] = FQuat(Out[0][Lane], Out[1][Lane], Out[2][Lane], Out[3][Lane]);
+			}
+		}
+	}
+}
+
+void FitPlanesBatch(
+	int32 BatchWidth,
+	TArrayView<const FBigNoobPlaneAccumulator* const> Accumulators,
+	TArrayView<FPlane> OutPlanes,
+	TArrayView<bool> bOutValid)
+{
+	check(Accumulators.Num() == OutPlanes.Num() && Accumulators.Num() == bOutValid.Num());
+
+	if (BatchWidth >= 16)
+	{
+		BigNoobPlaneBatch::FitPlanes<4>(Accumulators, OutPlanes, bOutValid);
+	}
+	else if (BatchWidth >= 8)
+	{
+		BigNoobPlaneBatch::FitPlanes<2>(Accumulators, OutPlanes, bOutValid);
+	}
+	else
+	{
+		BigNoobPlaneBatch::FitPlanes<1>(Accumulators, OutPlanes, bOutValid);
+	}
+}
+
+void FindQuatsFromPlanes(
+	int32 BatchWidth,
+	TArrayView<const FPlane> GroundPlanes,
+	TArrayView<const FQuat> CurrentRotations,
+	TArrayView<const FVector> LocalBaseNormals,
+	TArrayView<FQuat> OutRotations)
+{
+	check(GroundPlanes.Num() == CurrentRotations.Num() && GroundPlanes.Num() == LocalBaseNormals.Num() && GroundPlanes.Num() == OutRotations.Num());
+
+	if (BatchWidth >= 16)
+	{
+		BigNoobPlaneBatch::QuatsFromPlanes<4>(GroundPlanes, CurrentRotations, LocalBaseNormals, OutRotations);
+	}
+	else if (BatchWidth >= 8)
+	{
+		BigNoobPlaneBatch::QuatsFromPlanes<2>(GroundPlanes, CurrentRotations, LocalBaseNormals, OutRotations);
+	}
+	else
+	{
+		BigNoobPlaneBatch::QuatsFromPlanes<1>(GroundPlanes, CurrentRotations, LocalBaseNormals, OutRotations);
+	}
+}
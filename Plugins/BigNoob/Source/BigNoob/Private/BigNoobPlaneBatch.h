@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBigNoobPlaneAccumulator;
+
+/**
+*	FBigNoobPlaneAccumulator::GetPlane for many accumulators at once.
+*	The covariance eigen solves run BatchWidth (4, 8 or 16) independent problems together, one per SIMD lane,
+*	so fitting thousands of components is not dominated by one scalar solve after another.
+*	Where GetPlane would fail bOutValid[i] is false and OutPlanes[i] is a level plane through the points' centroid.
+*/
+void FitPlanesBatch(
+	int32 BatchWidth,
+	TArrayView<const FBigNoobPlaneAccumulator* const> Accumulators,
+	TArrayView<FPlane> OutPlanes,
+	TArrayView<bool> bOutValid);
+
+/**
+*	FindQuatFromPlane for many components at once, BatchWidth (4, 8 or 16) at a time in SIMD lanes.
+*	Branch-free on every lane, the yaw is kept without going through a rotator and opposite or near-vertical
+*	normals go through the same instructions as any other. OutRotations may be CurrentRotations.
+*/
+void FindQuatsFromPlanes(
+	int32 BatchWidth,
+	TArrayView<const FPlane> GroundPlanes,
+	TArrayView<const FQuat> CurrentRotations,
+	TArrayView<const FVector> LocalBaseNormals,
+	TArrayView<FQuat> OutRotations);
@@ -0,0 +1,598 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobPlaneEstimators.h"
+#include "BigNoobPlaneBatch.h"
+#include "Algo/Sort.h"
+#include "CompGeom/ConvexHull3.h"
+
+FVector CalculateCentroid(const FBigNoobPointView& Points)
+{
+	FVector Centroid(0.f, 0.f, 0.f);
+	for (int32 i = 0; i < Points.Num(); ++i)
+	{
+		Centroid += Points[i];
+	}
+	return Centroid / Points.Num();
+}
+
+void RemoveOutliers(TArray<FVector>& Points, const FVector& Centroid, float Threshold)
+{
+	float DistanceThresholdSquared = Threshold * Threshold;
+	for (int32 i = Points.Num() - 1; i >= 0; i--)
+	{
+		if (FVector::DistSquared(Points[i], Centroid) > DistanceThresholdSquared)
+		{
+			Points.RemoveAt(i);
+		}
+	}
+}
+
+void SolveSymmetric3x3(const double (&Matrix)[3][3], FVector& OutEigenvalues, FVector (&OutEigenvectors)[3])
+{
+	double A[3][3];
+	double V[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	double Scale = 0.0;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		for (int32 j = 0; j < 3; ++j)
+		{
+			A[i][j] = Matrix[i][j];
+			Scale += A[i][j] * A[i][j];
+		}
+	}
+
+	// Converges quadratically, a handful of sweeps reaches double precision
+	static constexpr int32 PairP[3] = { 0, 0, 1 };
+	static constexpr int32 PairQ[3] = { 1, 2, 2 };
+	for (int32 Sweep = 0; Sweep < 16; ++Sweep)
+	{
+		const double OffDiagonal = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+		if (OffDiagonal <= 1e-24 * Scale)
+		{
+			break;
+		}
+
+		for (int32 Pair = 0; Pair < 3; ++Pair)
+		{
+			const int32 P = PairP[Pair];
+			const int32 Q = PairQ[Pair];
+			if (A[P][Q] == 0.0)
+			{
+				continue;
+			}
+
+			// Rotation that zeroes A[P][Q]
+			const double Theta = (A[Q][Q] - A[P][P]) / (2.0 * A[P][Q]);
+			const double T = (Theta >= 0.0 ? 1.0 : -1.0) / (FMath::Abs(Theta) + FMath::Sqrt(Theta * Theta + 1.0));
+			const double C = 1.0 / FMath::Sqrt(T * T + 1.0);
+			const double S = T * C;
+
+			for (int32 k = 0; k < 3; ++k)
+			{
+				const double AKP = A[k][P];
+				const double AKQ = A[k][Q];
+				A[k][P] = C * AKP - S * AKQ;
+				A[k][Q] = S * AKP + C * AKQ;
+			}
+			for (int32 k = 0; k < 3; ++k)
+			{
+				const double APK = A[P][k];
+				const double AQK = A[Q][k];
+				A[P][k] = C * APK - S * AQK;
+				A[Q][k] = S * APK + C * AQK;
+			}
+			for (int32 k = 0; k < 3; ++k)
+			{
+				const double VKP = V[k][P];
+				const double VKQ = V[k][Q];
+				V[k][P] = C * VKP - S * VKQ;
+				V[k][Q] = S * VKP + C * VKQ;
+			}
+		}
+	}
+
+	int32 Order[3] = { 0, 1, 2 };
+	Algo::Sort(Order, [&A](int32 L, int32 R) { return A[L][L] < A[R][R]; });
+	for (int32 i = 0; i < 3; ++i)
+	{
+		OutEigenvalues[i] = A[Order[i]][Order[i]];
+		OutEigenvectors[i] = FVector(V[0][Order[i]], V[1][Order[i]], V[2][Order[i]]);
+	}
+}
+
+void FBigNoobPlaneAccumulator::Add(const FVector& Point)
+{
+	if (Count == 0)
+	{
+		Origin = Point;
+	}
+
+	const FVector P = Point - Origin;
+	Sum += P;
+	SumXX += P.X * P.X;
+	SumXY += P.X * P.Y;
+	SumXZ += P.X * P.Z;
+	SumYY += P.Y * P.Y;
+	SumYZ += P.Y * P.Z;
+	SumZZ += P.Z * P.Z;
+	++Count;
+}
+
+void FBigNoobPlaneAccumulator::Remove(const FVector& Point)
+{
+	if (Count <= 1)
+	{
+		*this = FBigNoobPlaneAccumulator();
+		return;
+	}
+
+	const FVector P = Point - Origin;
+	Sum -= P;
+	SumXX -= P.X * P.X;
+	SumXY -= P.X * P.Y;
+	SumXZ -= P.X * P.Z;
+	SumYY -= P.Y * P.Y;
+	SumYZ -= P.Y * P.Z;
+	SumZZ -= P.Z * P.Z;
+	--Count;
+}
+
+void FBigNoobPlaneAccumulator::GetCovariance(FVector& OutMean, double (&OutCovariance)[3][3]) const
+{
+	const double InvCount = 1.0 / Count;
+	OutMean = Sum * InvCount;
+	OutCovariance[0][0] = SumXX * InvCount - OutMean.X * OutMean.X;
+	OutCovariance[0][1] = OutCovariance[1][0] = SumXY * InvCount - OutMean.X * OutMean.Y;
+	OutCovariance[0][2] = OutCovariance[2][0] = SumXZ * InvCount - OutMean.X * OutMean.Z;
+	OutCovariance[1][1] = SumYY * InvCount - OutMean.Y * OutMean.Y;
+	OutCovariance[1][2] = OutCovariance[2][1] = SumYZ * InvCount - OutMean.Y * OutMean.Z;
+	OutCovariance[2][2] = SumZZ * InvCount - OutMean.Z * OutMean.Z;
+}
+
+bool FBigNoobPlaneAccumulator::GetMoments(FVector& OutCentroid, double (&OutCovariance)[3][3]) const
+{
+	if (Count < 3)
+	{
+		return false;
+	}
+
+	FVector Mean;
+	GetCovariance(Mean, OutCovariance);
+	OutCentroid = Origin + Mean;
+	return true;
+}
+
+bool FBigNoobPlaneAccumulator::Solve(FVector& OutMean, FVector& OutEigenvalues, FVector (&OutEigenvectors)[3]) const
+{
+	if (Count < 3)
+	{
+		return false;
+	}
+
+	double Covariance[3][3];
+	GetCovariance(OutMean, Covariance);
+	SolveSymmetric3x3(Covariance, OutEigenvalues, OutEigenvectors);
+
+	// Collinear points span no plane
+	return OutEigenvalues[1] > UE_DOUBLE_SMALL_NUMBER * FMath::Max(OutEigenvalues[2], 1.0);
+}
+
+bool FBigNoobPlaneAccumulator::GetPlane(FPlane& OutPlane) const
+{
+	FVector Mean, Eigenvalues, Eigenvectors[3];
+	if (!Solve(Mean, Eigenvalues, Eigenvectors))
+	{
+		return false;
+	}
+
+	OutPlane = FPlane(Origin + Mean, Eigenvectors[0]);
+	return true;
+}
+
+bool FBigNoobPlaneAccumulator::GetPlaneNear(const FVector& NormalGuess, FPlane& OutPlane) const
+{
+	FVector Normal = NormalGuess.GetSafeNormal();
+	if (Count < 3 || Normal.IsZero())
+	{
+		return GetPlane(OutPlane);
+	}
+
+	FVector Mean;
+	double C[3][3];
+	GetCovariance(Mean, C);
+
+	// The adjugate is det(C) * inverse(C), so multiplying by it is an inverse iteration step that stays finite
+	// for exactly coplanar points. Each step shrinks the guess's error by the two smallest eigenvalues' ratio.
+	const double Adjugate[3][3] = {
+		{ C[1][1] * C[2][2] - C[1][2] * C[2][1], C[0][2] * C[2][1] - C[0][1] * C[2][2], C[0][1] * C[1][2] - C[0][2] * C[1][1] },
+		{ C[1][2] * C[2][0] - C[1][0] * C[2][2], C[0][0] * C[2][2] - C[0][2] * C[2][0], C[0][2] * C[1][0] - C[0][0] * C[1][2] },
+		{ C[1][0] * C[2][1] - C[1][1] * C[2][0], C[0][1] * C[2][0] - C[0][0] * C[2][1], C[0][0] * C[1][1] - C[0][1] * C[1][0] } };
+	const double Trace = C[0][0] + C[1][1] + C[2][2];
+	const double MinLength = UE_DOUBLE_SMALL_NUMBER * FMath::Max(Trace * Trace, 1.0);
+
+	static constexpr int32 MaxIterations = 4;
+	for (int32 Iteration = 0; Iteration < MaxIterations; ++Iteration)
+	{
+		FVector Next;
+		for (int32 Row = 0; Row < 3; ++Row)
+		{
+			Next[Row] = Adjugate[Row][0] * Normal.X + Adjugate[Row][1] * Normal.Y + Adjugate[Row][2] * Normal.Z;
+		}
+		const double Length = Next.Size();
+		if (Length <= MinLength)
+		{
+			// Collinear points, or a guess orthogonal to the normal
+			return GetPlane(OutPlane);
+		}
+
+		Next /= Length;
+		if (FVector::DotProduct(Next, Normal) < 0.0)
+		{
+			Next = -Next;
+		}
+		const bool bConverged = FVector::DotProduct(Next, Normal) >= 1.0 - 1e-10;
+		Normal = Next;
+		if (bConverged)
+		{
+			OutPlane = FPlane(Origin + Mean, Normal);
+			return true;
+		}
+	}
+
+	// Far off, or the ground is about as wide as it is flat
+	return GetPlane(OutPlane);
+}
+
+double FBigNoobPlaneAccumulator::GetNormalConeAngle() const
+{
+	FVector Mean, Eigenvalues, Eigenvectors[3];
+	if (Count <= 3 || !Solve(Mean, Eigenvalues, Eigenvectors))
+	{
+		return UE_DOUBLE_PI;
+	}
+
+	// Unbiased residual variance off the plane against the spread along the plane's narrower axis.
+	// The normal tilts by about ResidualSigma / (sqrt(N) * InPlaneSigma) per standard deviation.
+	const double ResidualVariance = FMath::Max(Eigenvalues[0], 0.0) * Count / (Count - 3);
+	const double TiltSigma = FMath::Sqrt(ResidualVariance / (Count * Eigenvalues[1]));
+	return FMath::Atan(2.0 * TiltSigma);
+}
+
+double FBigNoobPlaneAccumulator::GetResidualVariance() const
+{
+	FVector Mean, Eigenvalues, Eigenvectors[3];
+	return Solve(Mean, Eigenvalues, Eigenvectors) ? FMath::Max(Eigenvalues[0], 0.0) : 0.0;
+}
+
+// Downdates only ever cancel to within rounding, a rebuild this often keeps that error negligible
+static constexpr int32 PlaneTrackerRebuildInterval = 4096;
+
+void FBigNoobPlaneTracker::Reset(int32 NumSlots)
+{
+	Accumulator = FBigNoobPlaneAccumulator();
+	Points.SetNumUninitialized(NumSlots);
+	bValid.Init(false, NumSlots);
+	UpdatesSinceRebuild = 0;
+}
+
+void FBigNoobPlaneTracker::SetPoint(int32 Slot, const FVector& Point)
+{
+	if (bValid[Slot])
+	{
+		if (Points[Slot] == Point)
+		{
+			return;
+		}
+		Accumulator.Remove(Points[Slot]);
+	}
+
+	Points[Slot] = Point;
+	bValid[Slot] = true;
+	Accumulator.Add(Point);
+	++UpdatesSinceRebuild;
+}
+
+void FBigNoobPlaneTracker::ClearPoint(int32 Slot)
+{
+	if (bValid[Slot])
+	{
+		Accumulator.Remove(Points[Slot]);
+		bValid[Slot] = false;
+		++UpdatesSinceRebuild;
+	}
+}
+
+bool FBigNoobPlaneTracker::GetPlane(FPlane& OutPlane)
+{
+	if (UpdatesSinceRebuild >= PlaneTrackerRebuildInterval)
+	{
+		Rebuild();
+	}
+
+	if (!Accumulator.GetPlaneNear(PreviousNormal, OutPlane))
+	{
+		return false;
+	}
+	PreviousNormal = OutPlane.GetSafeNormal();
+	return true;
+}
+
+void FBigNoobPlaneTracker::Rebuild()
+{
+	Accumulator = FBigNoobPlaneAccumulator();
+	for (TConstSetBitIterator<> It(bValid); It; ++It)
+	{
+		Accumulator.Add(Points[It.GetIndex()]);
+	}
+	UpdatesSinceRebuild = 0;
+}
+
+FPlane FitPlaneToPoints(const FBigNoobPointView& Points)
+{
+	FBigNoobPlaneAccumulator Accumulator;
+	for (int32 PointIndex = 0; PointIndex < Points.Num(); ++PointIndex)
+	{
+		Accumulator.Add(Points[PointIndex]);
+	}
+
+	FPlane Plane;
+	if (!Accumulator.GetPlane(Plane))
+	{
+		// Too few or collinear points, the best guess is a level plane through their centroid
+		return FPlane(Points.Num() > 0 ? CalculateCentroid(Points) : FVector::ZeroVector, FVector::UpVector);
+	}
+	return Plane;
+}
+
+bool ConstructPlaneFromPoints(const FVector& A, const FVector& B, const FVector& C, FPlane& OutPlane)
+{
+	FVector AB = B - A;
+	FVector AC = C - A;
+	FVector CrossProduct = FVector::CrossProduct(AB, AC);
+
+	// ĲȽӽ㣬㹲
+	if (CrossProduct.SizeSquared() <= KINDA_SMALL_NUMBER)
+	{
+		return false; // ߣ޷ƽ
+	}
+
+	FVector Normal = CrossProduct.GetSafeNormal();
+	OutPlane = FPlane(A, Normal);
+	return true; // ɹƽ
+}
+
+// Upper hemisphere octahedral histogram used to find the consensus normal
+static constexpr int32 MedianNormalBins = 16;
+static constexpr int32 MaxMedianTriples = 256;
+
+static FIntPoint NormalToMedianBin(const FVector& Normal)
+{
+	// Octahedral projection folds the hemisphere onto a diamond, rotating it 45 degrees fills the square
+	const double L1 = FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z);
+	const double U = Normal.X / L1;
+	const double V = Normal.Y / L1;
+	const double S = (U + V) * 0.5 + 0.5;
+	const double T = (U - V) * 0.5 + 0.5;
+	return FIntPoint(
+		FMath::Clamp(FMath::FloorToInt32(S * MedianNormalBins), 0, MedianNormalBins - 1),
+		FMath::Clamp(FMath::FloorToInt32(T * MedianNormalBins), 0, MedianNormalBins - 1));
+}
+
+FPlane FindMedianPlane(const FBigNoobPointView& HitPoints)
+{
+	const int32 NumPoints = HitPoints.Num();
+
+	// Fixed-size working set, the cost no longer grows with C(n,3)
+	TArray<FVector, TFixedAllocator<MaxMedianTriples>> Normals;
+	TArray<FVector, TFixedAllocator<MaxMedianTriples>> Anchors;
+	auto AddTriple = [&HitPoints, &Normals, &Anchors](int32 i, int32 j, int32 k)
+	{
+		FPlane NewPlane;
+		if (ConstructPlaneFromPoints(HitPoints[i], HitPoints[j], HitPoints[k], NewPlane))
+		{
+			// Triangle winding is arbitrary, fold every normal onto the upper hemisphere
+			const FVector Normal = NewPlane.GetSafeNormal();
+			Normals.Add(Normal.Z < 0.0 ? -Normal : Normal);
+			Anchors.Add(HitPoints[i]);
+		}
+	};
+
+	const int64 NumTriples = (int64)NumPoints * (NumPoints - 1) * (NumPoints - 2) / 6;
+	if (NumTriples <= MaxMedianTriples)
+	{
+		for (int32 i = 0; i < NumPoints - 2; ++i)
+		{
+			for (int32 j = i + 1; j < NumPoints - 1; ++j)
+			{
+				for (int32 k = j + 1; k < NumPoints; ++k)
+				{
+					AddTriple(i, j, k);
+				}
+			}
+		}
+	}
+	else
+	{
+		// Seeded from the input so the same hits always give the same plane
+		FRandomStream Random(NumPoints);
+		for (int32 Attempt = 0; Attempt < MaxMedianTriples * 4 && Normals.Num() < MaxMedianTriples; ++Attempt)
+		{
+			const int32 i = Random.RandHelper(NumPoints);
+			const int32 j = Random.RandHelper(NumPoints);
+			const int32 k = Random.RandHelper(NumPoints);
+			if (i != j && j != k && i != k)
+			{
+				AddTriple(i, j, k);
+			}
+		}
+	}
+
+	if (Normals.Num() == 0)
+	{
+		return FPlane(NumPoints > 0 ? CalculateCentroid(HitPoints) : FVector::ZeroVector, FVector::UpVector);
+	}
+
+	int32 Histogram[MedianNormalBins][MedianNormalBins] = {};
+	TArray<FIntPoint, TFixedAllocator<MaxMedianTriples>> Bins;
+	for (const FVector& Normal : Normals)
+	{
+		const FIntPoint Bin = NormalToMedianBin(Normal);
+		Bins.Add(Bin);
+		++Histogram[Bin.X][Bin.Y];
+	}
+
+	// The mode is the densest 3x3 neighbourhood, so a cluster straddling a bin edge is not split in two
+	FIntPoint ModeBin(0, 0);
+	int32 ModeCount = -1;
+	for (int32 X = 0; X < MedianNormalBins; ++X)
+	{
+		for (int32 Y = 0; Y < MedianNormalBins; ++Y)
+		{
+			int32 Count = 0;
+			for (int32 DX = FMath::Max(X - 1, 0); DX <= FMath::Min(X + 1, MedianNormalBins - 1); ++DX)
+			{
+				for (int32 DY = FMath::Max(Y - 1, 0); DY <= FMath::Min(Y + 1, MedianNormalBins - 1); ++DY)
+				{
+					Count += Histogram[DX][DY];
+				}
+			}
+			if (Count > ModeCount)
+			{
+				ModeCount = Count;
+				ModeBin = FIntPoint(X, Y);
+			}
+		}
+	}
+
+	auto IsInMode = [&Bins, &ModeBin](int32 Index)
+	{
+		return FMath::Abs(Bins[Index].X - ModeBin.X) <= 1 && FMath::Abs(Bins[Index].Y - ModeBin.Y) <= 1;
+	};
+
+	// Refine inside the mode with a few Weiszfeld steps towards the normal with the smallest summed
+	// distance to the others, the same median the exhaustive angle-sum search was looking for.
+	// Chord length grows monotonically with angle, so no acos is needed.
+	FVector MedianNormal = FVector::ZeroVector;
+	for (int32 Index = 0; Index < Normals.Num(); ++Index)
+	{
+		if (IsInMode(Index))
+		{
+			MedianNormal += Normals[Index];
+		}
+	}
+	MedianNormal = MedianNormal.GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector);
+
+	for (int32 Iteration = 0; Iteration < 8; ++Iteration)
+	{
+		FVector Weighted = FVector::ZeroVector;
+		for (int32 Index = 0; Index < Normals.Num(); ++Index)
+		{
+			if (IsInMode(Index))
+			{
+				Weighted += Normals[Index] / FMath::Max(FVector::Dist(Normals[Index], MedianNormal), 1e-4);
+			}
+		}
+		MedianNormal = Weighted.GetSafeNormal(UE_SMALL_NUMBER, MedianNormal);
+	}
+
+	// Median offset of the consensus triples keeps the plane itself robust to outliers as well
+	TArray<double, TFixedAllocator<MaxMedianTriples>> Offsets;
+	for (int32 Index = 0; Index < Normals.Num(); ++Index)
+	{
+		if (IsInMode(Index))
+		{
+			Offsets.Add(FVector::DotProduct(Anchors[Index], MedianNormal));
+		}
+	}
+	Offsets.Sort();
+
+	return FPlane(MedianNormal, Offsets[Offsets.Num() / 2]);
+}
+
+FPlane FindSupportPlane(const FBigNoobPointView& HitPoints, const FVector& CenterOfMass)
+{
+	// Quickhull, O(n log n) expected
+	UE::Geometry::FConvexHull3d Hull;
+	if (!Hull.Solve(HitPoints.Num(), [&HitPoints](int32 Index) { return HitPoints[Index]; }) || Hull.GetDimension() < 3)
+	{
+		// Coplanar hits, e.g. any flat floor, are fitted exactly in O(n), collinear ones give a level plane
+		return FitPlaneToPoints(HitPoints);
+	}
+
+	const FVector HullCentroid = CalculateCentroid(HitPoints);
+
+	bool bFoundFacet = false;
+	FPlane SupportPlane;
+	double NearestFacetDistSq = MAX_dbl;
+	for (const UE::Geometry::FIndex3i& Triangle : Hull.GetTriangles())
+	{
+		const FVector A = HitPoints[Triangle.A];
+		const FVector B = HitPoints[Triangle.B];
+		const FVector C = HitPoints[Triangle.C];
+		FVector Normal = FVector::CrossProduct(B - A, C - A).GetSafeNormal();
+
+		// Orient outward, then keep only facets the object could rest on
+		if (FVector::DotProduct(Normal, (A + B + C) / 3.0 - HullCentroid) < 0.0)
+		{
+			Normal = -Normal;
+		}
+		if (Normal.Z <= UE_KINDA_SMALL_NUMBER)
+		{
+			continue;
+		}
+
+		// Upward facets tile the hits' XY footprint, find the one the centre of mass projects into
+		const FVector2D P(CenterOfMass);
+		const FVector2D A2(A);
+		const FVector2D B2(B);
+		const FVector2D C2(C);
+		const double Area = FVector2D::CrossProduct(B2 - A2, C2 - A2);
+		if (FMath::Abs(Area) > UE_DOUBLE_SMALL_NUMBER)
+		{
+			const double U = FVector2D::CrossProduct(C2 - B2, P - B2) / Area;
+			const double V = FVector2D::CrossProduct(A2 - C2, P - C2) / Area;
+			if (U >= 0.0 && V >= 0.0 && U + V <= 1.0)
+			{
+				return FPlane(A, Normal);
+			}
+		}
+
+		// Centre of mass outside the hit footprint, the object would tip over the nearest edge
+		const double DistSq = FVector2D::DistSquared((A2 + B2 + C2) / 3.0, P);
+		if (DistSq < NearestFacetDistSq)
+		{
+			NearestFacetDistSq = DistSq;
+			SupportPlane = FPlane(A, Normal);
+			bFoundFacet = true;
+		}
+	}
+
+	return bFoundFacet ? SupportPlane : FitPlaneToPoints(HitPoints);
+}
+
+FPlane FindGroundPlane(const FBigNoobPointView& HitPoints, EBigNoobPlaneEstimator Estimator, const FVector& CenterOfMass)
+{
+	FPlane Plane;
+	switch (Estimator)
+	{
+	case EBigNoobPlaneEstimator::Support:		Plane = FindSupportPlane(HitPoints, CenterOfMass); break;
+	case EBigNoobPlaneEstimator::LeastSquares:	Plane = FitPlaneToPoints(HitPoints); break;
+	default:									Plane = FindMedianPlane(HitPoints); break;
+	}
+
+	// Triangle winding decides the sign of a constructed plane, ground always faces up
+	if (Plane.Z < 0.0)
+	{
+		Plane = Plane.Flip();
+	}
+	return Plane;
+}
+
+FQuat FindQuatFromPlane(const FPlane& GroundPlane, const FQuat& CurrentRotation, const FVector& LocalBaseNormal)
+{
+	// Keep the component's heading, then tilt its own base normal onto the ground normal.
+	// One lane of the batched kernel, so single and batched alignment agree to the last bit.
+	FQuat RotationQuat;
+	FindQuatsFromPlanes(4, MakeArrayView(&GroundPlane, 1), MakeArrayView(&CurrentRotation, 1), MakeArrayView(&LocalBaseNormal, 1), MakeArrayView(&RotationQuat, 1));
+	return RotationQuat;
+}
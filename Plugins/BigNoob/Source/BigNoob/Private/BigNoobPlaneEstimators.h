@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BigNoobAlignTypes.h"
+#include "BigNoobPointView.h"
+
+// Every estimator reads its points through a strided view, so they can run directly over
+// FHitResult arrays, vertex buffers or SoA buffers without copying the points out first.
+
+FVector CalculateCentroid(const FBigNoobPointView& Points);
+
+void RemoveOutliers(TArray<FVector>& Points, const FVector& Centroid, float Threshold);
+
+/** Least squares plane through the points, the normal is the covariance eigenvector with the smallest eigenvalue. */
+FPlane FitPlaneToPoints(const FBigNoobPointView& Points);
+
+/**
+*	Eigen decomposition of a symmetric 3x3 matrix by cyclic Jacobi rotations.
+*	Eigenvalues come out ascending, OutEigenvectors[i] is the unit eigenvector of OutEigenvalues[i].
+*/
+void SolveSymmetric3x3(const double (&Matrix)[3][3], FVector& OutEigenvalues, FVector (&OutEigenvectors)[3]);
+
+/**
+*	Least squares plane over points added one at a time, for sampling that stops as soon as the plane is known.
+*	Moments are kept relative to the first point, so adding a point is O(1) and the fit does not lose
+*	precision far from the world origin.
+*/
+class FBigNoobPlaneAccumulator
+{
+public:
+	void Add(const FVector& Point);
+
+	/** Rank-1 downdate, Point must have been added before. */
+	void Remove(const FVector& Point);
+
+	int32 Num() const { return Count; }
+
+	FVector GetCentroid() const { return Count > 0 ? Origin + Sum / Count : Origin; }
+
+	/** Centroid and covariance of the points for solvers outside the accumulator, false with fewer than 3 points. */
+	bool GetMoments(FVector& OutCentroid, double (&OutCovariance)[3][3]) const;
+
+	/** False with fewer than 3 points or when they are collinear. */
+	bool GetPlane(FPlane& OutPlane) const;
+
+	/**
+	*	GetPlane by a few steps of inverse iteration from a normal close to the answer, typically the previous fit.
+	*	Falls back to the full eigen solve when the guess is too far off to converge quickly.
+	*/
+	bool GetPlaneNear(const FVector& NormalGuess, FPlane& OutPlane) const;
+
+	/**
+	*	Half angle, in radians, of the ~95% confidence cone around the fitted normal.
+	*	Grows with the residual spread off the plane and shrinks with the number and spread of the points in it.
+	*	Exactly coplanar points give zero once there are more than three.
+	*/
+	double GetNormalConeAngle() const;
+
+	/** Mean squared distance of the points from the fitted plane, zero when there is no plane yet. */
+	double GetResidualVariance() const;
+
+private:
+	void GetCovariance(FVector& OutMean, double (&OutCovariance)[3][3]) const;
+	bool Solve(FVector& OutMean, FVector& OutEigenvalues, FVector (&OutEigenvectors)[3]) const;
+
+	FVector Origin = FVector::ZeroVector;
+	FVector Sum = FVector::ZeroVector;
+	double SumXX = 0.0, SumXY = 0.0, SumXZ = 0.0, SumYY = 0.0, SumYZ = 0.0, SumZZ = 0.0;
+	int32 Count = 0;
+};
+
+/**
+*	Least squares plane over a fixed set of probe slots of which only a few change between fits,
+*	like the probes of an actor following the ground every frame.
+*	Replacing a slot's point is a downdate and an update of the moments and the normal is warm-started
+*	from the previous fit, so a fit costs time proportional to the number of changed slots.
+*/
+class FBigNoobPlaneTracker
+{
+public:
+	/** Empties every slot. */
+	void Reset(int32 NumSlots);
+
+	void SetPoint(int32 Slot, const FVector& Point);
+
+	void ClearPoint(int32 Slot);
+
+	int32 Num() const { return Accumulator.Num(); }
+
+	/** False with fewer than 3 points or when they are collinear. */
+	bool GetPlane(FPlane& OutPlane);
+
+private:
+	/** Sums every point again, so downdate rounding does not build up and the origin follows the points. */
+	void Rebuild();
+
+	FBigNoobPlaneAccumulator Accumulator;
+	TArray<FVector> Points;
+	TBitArray<> bValid;
+	FVector PreviousNormal = FVector::ZeroVector;
+	int32 UpdatesSinceRebuild = 0;
+};
+
+bool ConstructPlaneFromPoints(const FVector& A, const FVector& B, const FVector& C, FPlane& OutPlane);
+
+/**
+*	Consensus plane of the hits, robust to outliers.
+*	Samples a bounded number of hit triples, bins their normals in an octahedral histogram
+*	and takes the median normal inside the densest bin. Time and memory do not depend on C(n,3).
+*/
+FPlane FindMedianPlane(const FBigNoobPointView& HitPoints);
+
+/**
+*	Plane an object centred over CenterOfMass would physically rest on.
+*	This is the upward facing facet of the hit points' convex hull that lies under the centre of mass,
+*	so every hit is on or below it.
+*/
+FPlane FindSupportPlane(const FBigNoobPointView& HitPoints, const FVector& CenterOfMass);
+
+/** Runs the chosen estimator, the returned plane's normal always points up. */
+FPlane FindGroundPlane(const FBigNoobPointView& HitPoints, EBigNoobPlaneEstimator Estimator, const FVector& CenterOfMass);
+
+/**
+*	Rotation that lays a mesh's base plane onto GroundPlane while keeping the yaw of CurrentRotation.
+*	LocalBaseNormal is the mesh's base normal in local space, already corrected for non-uniform scale.
+*/
+FQuat FindQuatFromPlane(const FPlane& GroundPlane, const FQuat& CurrentRotation, const FVector& LocalBaseNormal);
@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+#include "Rendering/PositionVertexBuffer.h"
+
+enum class EBigNoobPointPrecision : uint8
+{
+	Float,
+	Double,
+};
+
+/**
+*	Non-owning strided view over 3D points that live inside someone else's memory.
+*	Each coordinate has its own base pointer and all three share one stride, which covers
+*	interleaved structs (FHitResult::ImpactPoint, vertex buffers) as well as SoA component arrays.
+*	Lets the plane estimators run over those buffers without copying the points out first.
+*/
+class FBigNoobPointView
+{
+public:
+	FBigNoobPointView() = default;
+
+	/** Interleaved points: X, Y and Z are consecutive at Data, the next point starts Stride bytes later. */
+	FBigNoobPointView(const void* Data, int32 InStride, int32 InNum, EBigNoobPointPrecision InPrecision)
+		: Stride(InStride)
+		, NumPoints(InNum)
+		, Precision(InPrecision)
+	{
+		const int32 ComponentSize = Precision == EBigNoobPointPrecision::Float ? sizeof(float) : sizeof(double);
+		X = static_cast<const uint8*>(Data);
+		Y = X + ComponentSize;
+		Z = Y + ComponentSize;
+	}
+
+	/** Structure of arrays: one buffer per coordinate, all with the same stride. */
+	FBigNoobPointView(const void* InX, const void* InY, const void* InZ, int32 InStride, int32 InNum, EBigNoobPointPrecision InPrecision)
+		: X(static_cast<const uint8*>(InX))
+		, Y(static_cast<const uint8*>(InY))
+		, Z(static_cast<const uint8*>(InZ))
+		, Stride(InStride)
+		, NumPoints(InNum)
+		, Precision(InPrecision)
+	{
+	}
+
+	template<typename AllocatorType>
+	FBigNoobPointView(const TArray<FVector, AllocatorType>& Points)
+		: FBigNoobPointView(Points.GetData(), sizeof(FVector), Points.Num(), EBigNoobPointPrecision::Double)
+	{
+	}
+
+	template<typename AllocatorType>
+	FBigNoobPointView(const TArray<FVector3f, AllocatorType>& Points)
+		: FBigNoobPointView(Points.GetData(), sizeof(FVector3f), Points.Num(), EBigNoobPointPrecision::Float)
+	{
+	}
+
+	FBigNoobPointView(TArrayView<const FVector> Points)
+		: FBigNoobPointView(Points.GetData(), sizeof(FVector), Points.Num(), EBigNoobPointPrecision::Double)
+	{
+	}
+
+	FBigNoobPointView(TArrayView<const FVector3f> Points)
+		: FBigNoobPointView(Points.GetData(), sizeof(FVector3f), Points.Num(), EBigNoobPointPrecision::Float)
+	{
+	}
+
+	static FBigNoobPointView FromImpactPoints(TArrayView<const FHitResult> Hits)
+	{
+		return FBigNoobPointView(Hits.Num() > 0 ? &Hits[0].ImpactPoint : nullptr, sizeof(FHitResult), Hits.Num(), EBigNoobPointPrecision::Double);
+	}
+
+	/** Needs CPU access to the buffer, like any other read of its vertex data. */
+	static FBigNoobPointView FromPositionVertexBuffer(const FPositionVertexBuffer& Buffer)
+	{
+		return FBigNoobPointView(Buffer.GetVertexData(), Buffer.GetStride(), Buffer.GetVertexData() ? Buffer.GetNumVertices() : 0, EBigNoobPointPrecision::Float);
+	}
+
+	int32 Num() const { return NumPoints; }
+	bool IsEmpty() const { return NumPoints == 0; }
+
+	FORCEINLINE FVector operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < NumPoints);
+		const SIZE_T Offset = (SIZE_T)Index * Stride;
+		if (Precision == EBigNoobPointPrecision::Float)
+		{
+			return FVector(
+				*reinterpret_cast<const float*>(X + Offset),
+				*reinterpret_cast<const float*>(Y + Offset),
+				*reinterpret_cast<const float*>(Z + Offset));
+		}
+		return FVector(
+			*reinterpret_cast<const double*>(X + Offset),
+			*reinterpret_cast<const double*>(Y + Offset),
+			*reinterpret_cast<const double*>(Z + Offset));
+	}
+
+	/** Points [First, First + Count) of this view. */
+	FBigNoobPointView Slice(int32 First, int32 Count) const
+	{
+		check(First >= 0 && Count >= 0 && First + Count <= NumPoints);
+		const SIZE_T Offset = (SIZE_T)First * Stride;
+		return FBigNoobPointView(X + Offset, Y + Offset, Z + Offset, Stride, Count, Precision);
+	}
+
+private:
+	const uint8* X = nullptr;
+	const uint8* Y = nullptr;
+	const uint8* Z = nullptr;
+	int32 Stride = 0;
+	int32 NumPoints = 0;
+	EBigNoobPointPrecision Precision = EBigNoobPointPrecision::Double;
+};
@@ -0,0 +1,158 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobProbeHistory.h"
+#include "BigNoob.h"
+#include "BigNoobPlaneEstimators.h"
+#include "Components/PrimitiveComponent.h"
+
+static FIntPoint GetGroundCell(double X, double Y, double CellSize)
+{
+	return FIntPoint(FMath::FloorToInt32(X / CellSize), FMath::FloorToInt32(Y / CellSize));
+}
+
+FBigNoobProbeHistory::FBigNoobProbeHistory()
+	: PlaneTracker(MakeUnique<FBigNoobPlaneTracker>())
+{
+}
+
+FBigNoobProbeHistory::~FBigNoobProbeHistory() = default;
+
+void FBigNoobProbeHistory::Prepare(int32 NumProbes)
+{
+	if (Records.Num() != NumProbes)
+	{
+		Records.Reset();
+		Records.SetNum(NumProbes);
+		PlaneTracker->Reset(NumProbes);
+	}
+}
+
+void FBigNoobProbeHistory::ForgetFrom(int32 FirstProbe)
+{
+	for (int32 Probe = FMath::Max(FirstProbe, 0); Probe < Records.Num(); ++Probe)
+	{
+		Records[Probe].bValid = false;
+		PlaneTracker->ClearPoint(Probe);
+	}
+}
+
+void FBigNoobProbeHistory::Reproject(int32 FirstProbe, TArrayView<const FVector> Starts, TArrayView<const FVector> Ends, double CellSize,
+	TArrayView<FHitResult> OutHits, TArrayView<bool> bOutHits, TArrayView<bool> bOutReused) const
+{
+	for (int32 i = 0; i < Starts.Num(); ++i)
+	{
+		bOutReused[i] = false;
+		const int32 Probe = FirstProbe + i;
+		if (!Records.IsValidIndex(Probe) || !Records[Probe].bValid)
+		{
+			continue;
+		}
+
+		const FRecord& Record = Records[Probe];
+		if (GetGroundCell(Starts[i].X, Starts[i].Y, CellSize) != Record.GroundCell)
+		{
+			continue;
+		}
+
+		if (!Record.bHit)
+		{
+			// Nothing was under this cell last time either
+			bOutHits[i] = false;
+			bOutReused[i] = true;
+			continue;
+		}
+
+		// Height tile hits have no component and never move, any other ground must still exist where it was
+		if (!Record.Hit.Component.IsExplicitlyNull())
+		{
+			const UPrimitiveComponent* Ground = Record.Hit.Component.Get();
+			if (Ground == nullptr
+				|| !Ground->GetComponentLocation().Equals(Record.GroundLocation)
+				|| !Ground->GetComponentQuat().Equals(Record.GroundRotation))
+			{
+				continue;
+			}
+		}
+
+		// Slide the hit along the ground it hit, to under the probe's new position
+		const FVector& Normal = Record.Hit.ImpactNormal;
+		if (Normal.Z < 0.1)
+		{
+			continue;
+		}
+		const FVector Offset(Starts[i].X - Record.ProbeXY.X, Starts[i].Y - Record.ProbeXY.Y, 0.0);
+		const FVector Shift(Offset.X, Offset.Y, -(Normal.X * Offset.X + Normal.Y * Offset.Y) / Normal.Z);
+		const FVector ImpactPoint = Record.Hit.ImpactPoint + Shift;
+		if (ImpactPoint.Z > Starts[i].Z || ImpactPoint.Z < Ends[i].Z)
+		{
+			continue;
+		}
+
+		FHitResult& Hit = OutHits[i];
+		Hit = Record.Hit;
+		Hit.ImpactPoint = ImpactPoint;
+		Hit.Location = Record.Hit.Location + Shift;
+		Hit.TraceStart = Starts[i];
+		Hit.TraceEnd = Ends[i];
+		Hit.Time = (Starts[i].Z - ImpactPoint.Z) / FMath::Max(Starts[i].Z - Ends[i].Z, UE_SMALL_NUMBER);
+		Hit.Distance = Starts[i].Z - ImpactPoint.Z;
+		bOutHits[i] = true;
+		bOutReused[i] = true;
+	}
+}
+
+void FBigNoobProbeHistory::Record(int32 Probe, const FVector& Start, const FHitResult& Hit, bool bHit, double CellSize)
+{
+	if (!Records.IsValidIndex(Probe))
+	{
+		return;
+	}
+
+	FRecord& Record = Records[Probe];
+	Record.Hit = Hit;
+	Record.bHit = bHit;
+	Record.ProbeXY = FVector2D(Start.X, Start.Y);
+	Record.GroundCell = GetGroundCell(Start.X, Start.Y, CellSize);
+	if (const UPrimitiveComponent* Ground = Hit.Component.Get())
+	{
+		Record.GroundLocation = Ground->GetComponentLocation();
+		Record.GroundRotation = Ground->GetComponentQuat();
+	}
+	Record.bValid = true;
+
+	if (bHit)
+	{
+		PlaneTracker->SetPoint(Probe, Hit.ImpactPoint);
+	}
+	else
+	{
+		PlaneTracker->ClearPoint(Probe);
+	}
+}
+
+FBigNoobProbeHistory& UBigNoobProbeHistorySubsystem::FindOrAdd(const UPrimitiveComponent* Component, int32 InstanceIndex)
+{
+	LLM_SCOPE_BYTAG(BigNoob);
+	TUniquePtr<FBigNoobProbeHistory>& History = Histories.FindOrAdd(FKey(Component, InstanceIndex));
+	if (!History.IsValid())
+	{
+		History = MakeUnique<FBigNoobProbeHistory>();
+	}
+	return *History;
+}
+
+void UBigNoobProbeHistorySubsystem::PruneStale()
+{
+	for (auto It = Histories.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Key.ResolveObjectPtr() == nullptr)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UBigNoobProbeHistorySubsystem::ResetProbeHistory()
+{
+	Histories.Reset();
+}
@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BigNoobAlignTypes.h"
+
+/**
+*	Unit square probe layouts, generated at compile time or baked.
+*	Every table is progressive: any prefix of it is itself well spread over the square,
+*	so a layout of N probes is simply the first N entries.
+*/
+namespace BigNoobProbePatterns
+{
+	struct FUnitPoint
+	{
+		float X;
+		float Y;
+	};
+
+	template<int32 N>
+	struct TUnitTable
+	{
+		static constexpr int32 Num = N;
+		FUnitPoint Points[N];
+	};
+
+	constexpr double Frac(double Value)
+	{
+		return Value - (double)(int64)Value;
+	}
+
+	constexpr double RadicalInverse(uint32 Index, uint32 Base)
+	{
+		double Result = 0.0;
+		double Digit = 1.0 / Base;
+		for (; Index > 0; Index /= Base, Digit /= Base)
+		{
+			Result += (Index % Base) * Digit;
+		}
+		return Result;
+	}
+
+	/** Halton sequence in bases 2 and 3, skipping the origin. */
+	template<int32 N>
+	constexpr TUnitTable<N> MakeHaltonTable()
+	{
+		TUnitTable<N> Table = {};
+		for (int32 i = 0; i < N; ++i)
+		{
+			Table.Points[i] = { (float)RadicalInverse(i + 1, 2), (float)RadicalInverse(i + 1, 3) };
+		}
+		return Table;
+	}
+
+	/** Roberts' R2 sequence, the 2D additive recurrence on the plastic number. */
+	template<int32 N>
+	constexpr TUnitTable<N> MakeR2Table()
+	{
+		constexpr double Plastic = 1.32471795724474602596;
+		constexpr double A1 = 1.0 / Plastic;
+		constexpr double A2 = 1.0 / (Plastic * Plastic);
+
+		TUnitTable<N> Table = {};
+		for (int32 i = 0; i < N; ++i)
+		{
+			Table.Points[i] = { (float)Frac(0.5 + A1 * (i + 1)), (float)Frac(0.5 + A2 * (i + 1)) };
+		}
+		return Table;
+	}
+
+	inline constexpr TUnitTable<256> Halton = MakeHaltonTable<256>();
+	inline constexpr TUnitTable<256> R2 = MakeR2Table<256>();
+
+	/**
+	*	Poisson-disk-like layout from Mitchell's best candidate algorithm, baked because its cost is cubic in N.
+	*	Point i is the best of 10 * i + 1 candidates from an xorshift32 stream seeded with 0x9E3779B9, i.e. the
+	*	one furthest from all previous points, starting from the centre. The minimum spacing of every prefix is
+	*	about 0.8 / sqrt(N) or more, at 256 points twice the Halton table's.
+	*/
+	inline constexpr TUnitTable<256> Poisson = { {
+		{ 0.500000f, 0.500000f }, { 0.057779f, 0.960560f }, { 0.973972f, 0.982095f }, { 0.907963f, 0.047431f },
+		{ 0.323860f, 0.050952f }, { 0.061080f, 0.440456f }, { 0.961066f, 0.519857f }, { 0.504419f, 0.970094f },
+		{ 0.714260f, 0.735820f }, { 0.617252f, 0.174723f }, { 0.020041f, 0.104802f }, { 0.283802f, 0.709153f },
+		{ 0.401323f, 0.288618f }, { 0.788206f, 0.332854f }, { 0.031307f, 0.682980f }, { 0.975258f, 0.739953f },
+		{ 0.254716f, 0.503833f }, { 0.731666f, 0.997205f }, { 0.276173f, 0.950018f }, { 0.183834f, 0.230373f },
+		{ 0.484514f, 0.728630f }, { 0.976781f, 0.235417f }, { 0.697467f, 0.541085f }, { 0.627353f, 0.003341f },
+		{ 0.154660f, 0.008705f }, { 0.577260f, 0.343648f }, { 0.857161f, 0.854419f }, { 0.000978f, 0.269057f },
+		{ 0.465728f, 0.109572f }, { 0.168447f, 0.827350f }, { 0.639988f, 0.879928f }, { 0.838129f, 0.610803f },
+		{ 0.807744f, 0.183115f }, { 0.389401f, 0.858183f }, { 0.195284f, 0.379431f }, { 0.359850f, 0.598499f },
+		{ 0.985556f, 0.373775f }, { 0.601393f, 0.639474f }, { 0.769877f, 0.032419f }, { 0.351405f, 0.407794f },
+		{ 0.015419f, 0.834778f }, { 0.830847f, 0.473957f }, { 0.161714f, 0.600629f }, { 0.321616f, 0.174180f },
+		{ 0.712827f, 0.419638f }, { 0.857902f, 0.729476f }, { 0.845911f, 0.971295f }, { 0.596179f, 0.763874f },
+		{ 0.510305f, 0.239002f }, { 0.045443f, 0.561631f }, { 0.223782f, 0.108127f }, { 0.680191f, 0.276120f },
+		{ 0.471774f, 0.387891f }, { 0.510313f, 0.846142f }, { 0.991931f, 0.120178f }, { 0.390747f, 0.981072f },
+		{ 0.985093f, 0.857086f }, { 0.431024f, 0.003218f }, { 0.486985f, 0.614779f }, { 0.995497f, 0.630515f },
+		{ 0.615997f, 0.987437f }, { 0.280102f, 0.824878f }, { 0.287676f, 0.305801f }, { 0.750662f, 0.872166f },
+		{ 0.603482f, 0.461586f }, { 0.872068f, 0.265281f }, { 0.142169f, 0.718060f }, { 0.171846f, 0.971740f },
+		{ 0.086369f, 0.340200f }, { 0.383551f, 0.745743f }, { 0.106259f, 0.161487f }, { 0.053780f, 0.002427f },
+		{ 0.567526f, 0.081946f }, { 0.678467f, 0.097003f }, { 0.151546f, 0.495538f }, { 0.905840f, 0.167066f },
+		{ 0.749856f, 0.644443f }, { 0.880309f, 0.381730f }, { 0.397621f, 0.510550f }, { 0.266518f, 0.607198f },
+		{ 0.525891f, 0.007682f }, { 0.249786f, 0.004857f }, { 0.576251f, 0.552087f }, { 0.719658f, 0.176539f },
+		{ 0.988131f, 0.007299f }, { 0.100040f, 0.251624f }, { 0.427620f, 0.200377f }, { 0.090253f, 0.802443f },
+		{ 0.421303f, 0.666365f }, { 0.839639f, 0.101105f }, { 0.916928f, 0.914599f }, { 0.909825f, 0.661178f },
+		{ 0.214986f, 0.752134f }, { 0.789160f, 0.779927f }, { 0.123571f, 0.901046f }, { 0.004763f, 0.369332f },
+		{ 0.537458f, 0.162081f }, { 0.594859f, 0.260921f }, { 0.385478f, 0.127831f }, { 0.101694f, 0.073403f },
+		{ 0.270179f, 0.421538f }, { 0.762392f, 0.250900f }, { 0.910454f, 0.583566f }, { 0.206460f, 0.669206f },
+		{ 0.484518f, 0.310264f }, { 0.924043f, 0.803534f }, { 0.218501f, 0.890679f }, { 0.940389f, 0.440302f },
+		{ 0.453747f, 0.906245f }, { 0.561718f, 0.911710f }, { 0.656561f, 0.360414f }, { 0.013126f, 0.189396f },
+		{ 0.445110f, 0.800119f }, { 0.769875f, 0.514822f }, { 0.000313f, 0.491181f }, { 0.673231f, 0.665273f },
+		{ 0.929985f, 0.320652f }, { 0.210304f, 0.302486f }, { 0.099918f, 0.649576f }, { 0.701310f, 0.812201f },
+		{ 0.256457f, 0.222723f }, { 0.003067f, 0.908909f }, { 0.337287f, 0.249674f }, { 0.345547f, 0.920738f },
+		{ 0.544526f, 0.414726f }, { 0.752775f, 0.105033f }, { 0.012878f, 0.756830f }, { 0.419484f, 0.441153f },
+		{ 0.328674f, 0.478453f }, { 0.543962f, 0.683908f }, { 0.789407f, 0.411913f }, { 0.840634f, 0.006684f },
+		{ 0.785354f, 0.705259f }, { 0.340895f, 0.670116f }, { 0.711376f, 0.929656f }, { 0.707201f, 0.000111f },
+		{ 0.134478f, 0.424653f }, { 0.406172f, 0.360598f }, { 0.860148f, 0.537241f }, { 0.781235f, 0.937540f },
+		{ 0.640268f, 0.579267f }, { 0.086110f, 0.507489f }, { 0.578628f, 0.838343f }, { 0.309271f, 0.553467f },
+		{ 0.438510f, 0.565228f }, { 0.174235f, 0.160900f }, { 0.316483f, 0.768126f }, { 0.996396f, 0.305742f },
+		{ 0.292622f, 0.113527f }, { 0.667242f, 0.481930f }, { 0.320524f, 0.998314f }, { 0.112721f, 0.998598f },
+		{ 0.211180f, 0.449417f }, { 0.219602f, 0.560563f }, { 0.254706f, 0.359576f }, { 0.413057f, 0.067268f },
+		{ 0.908727f, 0.987867f }, { 0.002932f, 0.621261f }, { 0.780579f, 0.583066f }, { 0.071337f, 0.733684f },
+		{ 0.713866f, 0.333123f }, { 0.338197f, 0.345271f }, { 0.534192f, 0.784420f }, { 0.068996f, 0.869240f },
+		{ 0.895988f, 0.480874f }, { 0.147039f, 0.295730f }, { 0.108332f, 0.566862f }, { 0.649269f, 0.728957f },
+		{ 0.474723f, 0.043208f }, { 0.173503f, 0.070655f }, { 0.983012f, 0.920079f }, { 0.697922f, 0.602038f },
+		{ 0.671646f, 0.213961f }, { 0.005071f, 0.999161f }, { 0.858486f, 0.792050f }, { 0.365001f, 0.004178f },
+		{ 0.998526f, 0.459802f }, { 0.295480f, 0.888652f }, { 0.938554f, 0.096562f }, { 0.000090f, 0.048668f },
+		{ 0.557150f, 0.998125f }, { 0.865131f, 0.324115f }, { 0.625426f, 0.070055f }, { 0.964824f, 0.172529f },
+		{ 0.346300f, 0.819468f }, { 0.609684f, 0.398582f }, { 0.993674f, 0.569991f }, { 0.637841f, 0.819564f },
+		{ 0.839274f, 0.912471f }, { 0.845150f, 0.670114f }, { 0.676225f, 0.977617f }, { 0.254214f, 0.161423f },
+		{ 0.032635f, 0.318563f }, { 0.546829f, 0.605018f }, { 0.541628f, 0.293112f }, { 0.918525f, 0.721838f },
+		{ 0.793574f, 0.997080f }, { 0.481886f, 0.179239f }, { 0.226990f, 0.993801f }, { 0.994581f, 0.797469f },
+		{ 0.450856f, 0.255966f }, { 0.727726f, 0.475347f }, { 0.815798f, 0.281286f }, { 0.919277f, 0.227043f },
+		{ 0.266949f, 0.059807f }, { 0.481536f, 0.443179f }, { 0.802284f, 0.849276f }, { 0.602293f, 0.695434f },
+		{ 0.450491f, 0.995058f }, { 0.628022f, 0.308526f }, { 0.505630f, 0.559987f }, { 0.001141f, 0.430610f },
+		{ 0.401029f, 0.925614f }, { 0.864278f, 0.207460f }, { 0.964669f, 0.679880f }, { 0.484384f, 0.671941f },
+		{ 0.521971f, 0.353989f }, { 0.992712f, 0.063901f }, { 0.148962f, 0.773800f }, { 0.138487f, 0.365416f },
+		{ 0.605857f, 0.121684f }, { 0.920797f, 0.860196f }, { 0.554794f, 0.488202f }, { 0.047094f, 0.234067f },
+		{ 0.630132f, 0.934169f }, { 0.228069f, 0.803594f }, { 0.140646f, 0.114207f }, { 0.567172f, 0.209044f },
+		{ 0.713077f, 0.053910f }, { 0.153437f, 0.652921f }, { 0.695126f, 0.874810f }, { 0.371643f, 0.206896f },
+		{ 0.307407f, 0.001442f }, { 0.629950f, 0.525391f }, { 0.747044f, 0.377109f }, { 0.582835f, 0.030613f },
+		{ 0.515739f, 0.080746f }, { 0.509924f, 0.900699f }, { 0.827441f, 0.374382f }, { 0.051696f, 0.059764f },
+		{ 0.415329f, 0.614765f }, { 0.132305f, 0.208296f }, { 0.217068f, 0.942654f }, { 0.061076f, 0.385442f },
+		{ 0.657848f, 0.423145f }, { 0.665587f, 0.152717f }, { 0.071420f, 0.120890f }, { 0.060582f, 0.612626f },
+		{ 0.874688f, 0.432540f }, { 0.168885f, 0.549448f }, { 0.552197f, 0.736092f }, { 0.445084f, 0.489565f },
+		{ 0.932734f, 0.376665f }, { 0.214309f, 0.615662f }, { 0.278612f, 0.655924f }, { 0.853226f, 0.154615f },
+	} };
+
+	/** Table of the given pattern, or an empty view for the regular grid. */
+	inline TArrayView<const FUnitPoint> GetTable(EBigNoobProbePattern Pattern)
+	{
+		switch (Pattern)
+		{
+		case EBigNoobProbePattern::Halton:		return MakeArrayView(Halton.Points, Halton.Num);
+		case EBigNoobProbePattern::R2:			return MakeArrayView(R2.Points, R2.Num);
+		case EBigNoobProbePattern::PoissonDisk:	return MakeArrayView(Poisson.Points, Poisson.Num);
+		default:								return TArrayView<const FUnitPoint>();
+		}
+	}
+}
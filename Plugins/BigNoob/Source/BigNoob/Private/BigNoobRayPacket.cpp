@@ -0,0 +1,278 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobRayPacket.h"
+#include "BigNoobGroundMeshCache.h"
+#include "Engine/HitResult.h"
+#include "Math/VectorRegister.h"
+
+using namespace UE::Geometry;
+
+namespace BigNoobRayPacket
+{
+	/**
+	*	Structure-of-arrays ray packet in mesh local space, 4 rays per register.
+	*	Everything is stored relative to the first ray origin so float precision holds on large meshes.
+	*	Rays are parameterised over [0, 1] from start to end, so a hit's t is directly FHitResult::Time.
+	*/
+	template<int32 NumRegs>
+	struct TPacket
+	{
+		static constexpr int32 Width = NumRegs * 4;
+
+		FVector3d Reference;
+		VectorRegister4Float OriginX[NumRegs], OriginY[NumRegs], OriginZ[NumRegs];
+		VectorRegister4Float DirX[NumRegs], DirY[NumRegs], DirZ[NumRegs];
+		VectorRegister4Float InvDirX[NumRegs], InvDirY[NumRegs], InvDirZ[NumRegs];
+		VectorRegister4Float MaxT[NumRegs];
+		int32 HitTriangle[Width];
+
+		const FDynamicMesh3* Mesh = nullptr;
+	};
+
+	// Zero direction components would produce 0 * inf = NaN in the slab test, nudge them instead
+	FORCEINLINE float SafeInverse(double Value)
+	{
+		constexpr double Tiny = 1e-30;
+		return (float)(1.0 / (FMath::Abs(Value) > Tiny ? Value : (Value < 0.0 ? -Tiny : Tiny)));
+	}
+
+	template<int32 NumRegs>
+	void Load(TPacket<NumRegs>& Packet, const FVector* LocalStarts, const FVector* LocalDeltas, int32 NumRays)
+	{
+		constexpr int32 Width = TPacket<NumRegs>::Width;
+		alignas(16) float Ox[Width], Oy[Width], Oz[Width], Dx[Width], Dy[Width], Dz[Width], Ix[Width], Iy[Width], Iz[Width], T[Width];
+
+		Packet.Reference = LocalStarts[0];
+		for (int32 Lane = 0; Lane < Width; ++Lane)
+		{
+			// Padding lanes repeat the first ray so they never widen traversal, and can never accept a hit
+			const int32 Ray = Lane < NumRays ? Lane : 0;
+			const FVector Origin = LocalStarts[Ray] - Packet.Reference;
+			const FVector& Delta = LocalDeltas[Ray];
+			Ox[Lane] = (float)Origin.X;
+			Oy[Lane] = (float)Origin.Y;
+			Oz[Lane] = (float)Origin.Z;
+			Dx[Lane] = (float)Delta.X;
+			Dy[Lane] = (float)Delta.Y;
+			Dz[Lane] = (float)Delta.Z;
+			Ix[Lane] = SafeInverse(Delta.X);
+			Iy[Lane] = SafeInverse(Delta.Y);
+			Iz[Lane] = SafeInverse(Delta.Z);
+			T[Lane] = Lane < NumRays ? 1.0f : -1.0f;
+			Packet.HitTriangle[Lane] = IndexConstants::InvalidID;
+		}
+
+		for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+		{
+			const int32 Offset = Reg * 4;
+			Packet.OriginX[Reg] = VectorLoadAligned(Ox + Offset);
+			Packet.OriginY[Reg] = VectorLoadAligned(Oy + Offset);
+			Packet.OriginZ[Reg] = VectorLoadAligned(Oz + Offset);
+			Packet.DirX[Reg] = VectorLoadAligned(Dx + Offset);
+			Packet.DirY[Reg] = VectorLoadAligned(Dy + Offset);
+			Packet.DirZ[Reg] = VectorLoadAligned(Dz + Offset);
+			Packet.InvDirX[Reg] = VectorLoadAligned(Ix + Offset);
+			Packet.InvDirY[Reg] = VectorLoadAligned(Iy + Offset);
+			Packet.InvDirZ[Reg] = VectorLoadAligned(Iz + Offset);
+			Packet.MaxT[Reg] = VectorLoadAligned(T + Offset);
+		}
+	}
+
+	/** Slab test of every lane against one box, true when any lane may still find a closer hit inside it. */
+	template<int32 NumRegs>
+	bool IntersectsBox(const TPacket<NumRegs>& Packet, const FAxisAlignedBox3d& Box)
+	{
+		const FVector3d Min = Box.Min - Packet.Reference;
+		const FVector3d Max = Box.Max - Packet.Reference;
+		const VectorRegister4Float MinX = VectorSetFloat1((float)Min.X);
+		const VectorRegister4Float MinY = VectorSetFloat1((float)Min.Y);
+		const VectorRegister4Float MinZ = VectorSetFloat1((float)Min.Z);
+		const VectorRegister4Float MaxX = VectorSetFloat1((float)Max.X);
+		const VectorRegister4Float MaxY = VectorSetFloat1((float)Max.Y);
+		const VectorRegister4Float MaxZ = VectorSetFloat1((float)Max.Z);
+		const VectorRegister4Float Zero = VectorZeroFloat();
+
+		for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+		{
+			const VectorRegister4Float T1X = VectorMultiply(VectorSubtract(MinX, Packet.OriginX[Reg]), Packet.InvDirX[Reg]);
+			const VectorRegister4Float T2X = VectorMultiply(VectorSubtract(MaxX, Packet.OriginX[Reg]), Packet.InvDirX[Reg]);
+			const VectorRegister4Float T1Y = VectorMultiply(VectorSubtract(MinY, Packet.OriginY[Reg]), Packet.InvDirY[Reg]);
+			const VectorRegister4Float T2Y = VectorMultiply(VectorSubtract(MaxY, Packet.OriginY[Reg]), Packet.InvDirY[Reg]);
+			const VectorRegister4Float T1Z = VectorMultiply(VectorSubtract(MinZ, Packet.OriginZ[Reg]), Packet.InvDirZ[Reg]);
+			const VectorRegister4Float T2Z = VectorMultiply(VectorSubtract(MaxZ, Packet.OriginZ[Reg]), Packet.InvDirZ[Reg]);
+
+			const VectorRegister4Float Near = VectorMax(VectorMax(VectorMin(T1X, T2X), VectorMin(T1Y, T2Y)), VectorMin(T1Z, T2Z));
+			const VectorRegister4Float Far = VectorMin(VectorMin(VectorMax(T1X, T2X), VectorMax(T1Y, T2Y)), VectorMax(T1Z, T2Z));
+
+			const VectorRegister4Float Hit = VectorBitwiseAnd(
+				VectorBitwiseAnd(VectorCompareLE(Near, Far), VectorCompareGE(Far, Zero)),
+				VectorCompareLE(Near, Packet.MaxT[Reg]));
+
+			if (VectorMaskBits(Hit) != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** Moller-Trumbore against one triangle for every lane, shrinking MaxT where a lane hits. */
+	template<int32 NumRegs>
+	void IntersectTriangle(TPacket<NumRegs>& Packet, int32 TriangleID)
+	{
+		FVector3d A, B, C;
+		Packet.Mesh->GetTriVertices(TriangleID, A, B, C);
+		A -= Packet.Reference;
+		const FVector3d Edge1 = B - Packet.Reference - A;
+		const FVector3d Edge2 = C - Packet.Reference - A;
+
+		const VectorRegister4Float AX = VectorSetFloat1((float)A.X);
+		const VectorRegister4Float AY = VectorSetFloat1((float)A.Y);
+		const VectorRegister4Float AZ = VectorSetFloat1((float)A.Z);
+		const VectorRegister4Float E1X = VectorSetFloat1((float)Edge1.X);
+		const VectorRegister4Float E1Y = VectorSetFloat1((float)Edge1.Y);
+		const VectorRegister4Float E1Z = VectorSetFloat1((float)Edge1.Z);
+		const VectorRegister4Float E2X = VectorSetFloat1((float)Edge2.X);
+		const VectorRegister4Float E2Y = VectorSetFloat1((float)Edge2.Y);
+		const VectorRegister4Float E2Z = VectorSetFloat1((float)Edge2.Z);
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float DetEpsilon = VectorSetFloat1(UE_SMALL_NUMBER);
+
+		for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+		{
+			const VectorRegister4Float& DX = Packet.DirX[Reg];
+			const VectorRegister4Float& DY = Packet.DirY[Reg];
+			const VectorRegister4Float& DZ = Packet.DirZ[Reg];
+
+			// P = Dir x Edge2
+			const VectorRegister4Float PX = VectorSubtract(VectorMultiply(DY, E2Z), VectorMultiply(DZ, E2Y));
+			const VectorRegister4Float PY = VectorSubtract(VectorMultiply(DZ, E2X), VectorMultiply(DX, E2Z));
+			const VectorRegister4Float PZ = VectorSubtract(VectorMultiply(DX, E2Y), VectorMultiply(DY, E2X));
+			const VectorRegister4Float Det = VectorMultiplyAdd(E1X, PX, VectorMultiplyAdd(E1Y, PY, VectorMultiply(E1Z, PZ)));
+			const VectorRegister4Float InvDet = VectorDivide(One, Det);
+
+			// S = Origin - A, Q = S x Edge1
+			const VectorRegister4Float SX = VectorSubtract(Packet.OriginX[Reg], AX);
+			const VectorRegister4Float SY = VectorSubtract(Packet.OriginY[Reg], AY);
+			const VectorRegister4Float SZ = VectorSubtract(Packet.OriginZ[Reg], AZ);
+			const VectorRegister4Float QX = VectorSubtract(VectorMultiply(SY, E1Z), VectorMultiply(SZ, E1Y));
+			const VectorRegister4Float QY = VectorSubtract(VectorMultiply(SZ, E1X), VectorMultiply(SX, E1Z));
+			const VectorRegister4Float QZ = VectorSubtract(VectorMultiply(SX, E1Y), VectorMultiply(SY, E1X));
+
+			const VectorRegister4Float U = VectorMultiply(VectorMultiplyAdd(SX, PX, VectorMultiplyAdd(SY, PY, VectorMultiply(SZ, PZ))), InvDet);
+			const VectorRegister4Float V = VectorMultiply(VectorMultiplyAdd(DX, QX, VectorMultiplyAdd(DY, QY, VectorMultiply(DZ, QZ))), InvDet);
+			const VectorRegister4Float T = VectorMultiply(VectorMultiplyAdd(E2X, QX, VectorMultiplyAdd(E2Y, QY, VectorMultiply(E2Z, QZ))), InvDet);
+
+			VectorRegister4Float Hit = VectorCompareGT(VectorAbs(Det), DetEpsilon);
+			Hit = VectorBitwiseAnd(Hit, VectorCompareGE(U, Zero));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareGE(V, Zero));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareLE(VectorAdd(U, V), One));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareGE(T, Zero));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareLT(T, Packet.MaxT[Reg]));
+
+			int32 HitBits = VectorMaskBits(Hit);
+			if (HitBits != 0)
+			{
+				Packet.MaxT[Reg] = VectorSelect(Hit, T, Packet.MaxT[Reg]);
+				while (HitBits != 0)
+				{
+					const int32 Lane = FMath::CountTrailingZeros((uint32)HitBits);
+					Packet.HitTriangle[Reg * 4 + Lane] = TriangleID;
+					HitBits &= HitBits - 1;
+				}
+			}
+		}
+	}
+
+	template<int32 NumRegs>
+	void TraceRays(
+		const FBigNoobGroundMesh& GroundMesh,
+		const FTransform& MeshToWorld,
+		TArrayView<const FVector> Starts,
+		TArrayView<const FVector> Ends,
+		TArrayView<FHitResult> OutHits,
+		TArrayView<bool> bOutHits)
+	{
+		constexpr int32 Width = TPacket<NumRegs>::Width;
+
+		TPacket<NumRegs> Packet;
+		Packet.Mesh = &GroundMesh.GetMesh();
+
+		// Both callbacks only capture the packet, keeping the TFunctions inside their inline storage
+		TPacket<NumRegs>* PacketPtr = &Packet;
+		FDynamicMeshAABBTree3::FTreeTraversal Traversal;
+		Traversal.NextBoxF = [PacketPtr](const FAxisAlignedBox3d& Box, int32 Depth)
+		{
+			return IntersectsBox(*PacketPtr, Box);
+		};
+		Traversal.NextTriangleF = [PacketPtr](int32 TriangleID)
+		{
+			IntersectTriangle(*PacketPtr, TriangleID);
+		};
+
+		FVector LocalStarts[Width];
+		FVector LocalDeltas[Width];
+		alignas(16) float HitT[Width];
+
+		for (int32 First = 0; First < Starts.Num(); First += Width)
+		{
+			const int32 NumRays = FMath::Min(Width, Starts.Num() - First);
+			for (int32 Lane = 0; Lane < NumRays; ++Lane)
+			{
+				LocalStarts[Lane] = MeshToWorld.InverseTransformPosition(Starts[First + Lane]);
+				LocalDeltas[Lane] = MeshToWorld.InverseTransformPosition(Ends[First + Lane]) - LocalStarts[Lane];
+			}
+
+			Load(Packet, LocalStarts, LocalDeltas, NumRays);
+			GroundMesh.GetTree().DoTraversal(Traversal);
+
+			for (int32 Reg = 0; Reg < NumRegs; ++Reg)
+			{
+				VectorStoreAligned(Packet.MaxT[Reg], HitT + Reg * 4);
+			}
+
+			for (int32 Lane = 0; Lane < NumRays; ++Lane)
+			{
+				const int32 Ray = First + Lane;
+				if (Packet.HitTriangle[Lane] == IndexConstants::InvalidID)
+				{
+					continue;
+				}
+				if (bOutHits[Ray] && OutHits[Ray].Time <= HitT[Lane])
+				{
+					continue;
+				}
+
+				// Triangle tests ran in float, hand the final point to the shared double precision path
+				GroundMesh.MakeHitResult(MeshToWorld, Starts[Ray], Ends[Ray], HitT[Lane], Packet.HitTriangle[Lane], OutHits[Ray]);
+				bOutHits[Ray] = true;
+			}
+		}
+	}
+}
+
+void RaycastGroundMeshPackets(
+	const FBigNoobGroundMesh& GroundMesh,
+	const FTransform& MeshToWorld,
+	int32 PacketWidth,
+	TArrayView<const FVector> Starts,
+	TArrayView<const FVector> Ends,
+	TArrayView<FHitResult> OutHits,
+	TArrayView<bool> bOutHits)
+{
+	check(Starts.Num() == Ends.Num() && Starts.Num() == OutHits.Num() && Starts.Num() == bOutHits.Num());
+
+	if (PacketWidth >= 16)
+	{
+		BigNoobRayPacket::TraceRays<4>(GroundMesh, MeshToWorld, Starts, Ends, OutHits, bOutHits);
+	}
+	else if (PacketWidth >= 8)
+	{
+		BigNoobRayPacket::TraceRays<2>(GroundMesh, MeshToWorld, Starts, Ends, OutHits, bOutHits);
+	}
+	else
+	{
+		BigNoobRayPacket::TraceRays<1>(GroundMesh, MeshToWorld, Starts, Ends, OutHits, bOutHits);
+	}
+}
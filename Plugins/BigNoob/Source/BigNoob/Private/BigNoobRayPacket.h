@@ -0,0 +1,23 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBigNoobGroundMesh;
+struct FHitResult;
+
+/**
+*	Raycasts Starts[i] -> Ends[i] against a cached ground mesh, PacketWidth (4, 8 or 16) rays at a time.
+*	Each packet walks the BVH once with SIMD slab and triangle tests, which pays off for coherent rays
+*	such as the parallel downward probes of an alignment lattice.
+*	Only lanes whose hit is closer than the current OutHits[i] (when bOutHits[i] is already set) are overwritten.
+*/
+void RaycastGroundMeshPackets(
+	const FBigNoobGroundMesh& GroundMesh,
+	const FTransform& MeshToWorld,
+	int32 PacketWidth,
+	TArrayView<const FVector> Starts,
+	TArrayView<const FVector> Ends,
+	TArrayView<FHitResult> OutHits,
+	TArrayView<bool> bOutHits);
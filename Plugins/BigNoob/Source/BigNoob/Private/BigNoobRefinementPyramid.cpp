@@ -0,0 +1,140 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BigNoobRefinementPyramid.h"
+#include "BigNoobGroundTrace.h"
+#include "BigNoobPlaneEstimators.h"
+
+// Probes per node along each axis
+static constexpr int32 PyramidLattice = 4;
+static constexpr int32 PyramidNodeProbes = PyramidLattice * PyramidLattice;
+
+int32 RefineGroundPyramid(
+	const FBigNoobGroundTracer& GroundTracer,
+	const AActor* IgnoredActor,
+	const FBigNoobAlignOptions& Options,
+	const FTransform& LocalToWorld,
+	const FBox2D& LocalRect,
+	double LocalZ,
+	double StartZ,
+	TArray<FHitResult, TMemStackAllocator<>>& OutHits,
+	TArray<FBigNoobGroundPatch>& OutPatches)
+{
+	struct FNode
+	{
+		FBox2D Rect;
+		int32 Depth;
+		FVector ParentNormal; // Zero for the root
+	};
+
+	const double ResidualThresholdSq = FMath::Square((double)Options.PyramidResidualThreshold);
+	const double NormalThresholdCos = FMath::Cos(FMath::DegreesToRadians((double)Options.PyramidNormalThreshold));
+
+	TArray<FNode, TInlineAllocator<32>> Pending;
+	Pending.Add({ LocalRect, 0, FVector::ZeroVector });
+
+	FVector Starts[PyramidNodeProbes];
+	FVector Ends[PyramidNodeProbes];
+	FHitResult NodeHits[PyramidNodeProbes];
+	bool bNodeHits[PyramidNodeProbes];
+	FVector NodePoints[PyramidNodeProbes];
+	int32 NumProbes = 0;
+
+	auto AddPatch = [&OutPatches, &LocalToWorld, LocalZ](const FBox2D& Rect, const FPlane& Plane, int32 Depth, const FBigNoobPlaneAccumulator& Accumulator)
+	{
+		FBigNoobGroundPatch& Patch = OutPatches.AddDefaulted_GetRef();
+		Patch.Center = LocalToWorld.TransformPosition(FVector(Rect.GetCenter().X, Rect.GetCenter().Y, LocalZ));
+		Patch.Extent = Rect.GetExtent();
+		Patch.Plane = Plane;
+		Patch.Depth = Depth;
+		Patch.ResidualRMS = FMath::Sqrt(Accumulator.GetResidualVariance());
+		Patch.NumHits = Accumulator.Num();
+	};
+
+	while (Pending.Num() > 0)
+	{
+		const FNode Node = Pending.Pop(EAllowShrinking::No);
+		const FVector2D CellSize = Node.Rect.GetSize() / PyramidLattice;
+
+		// Cell centres, so a child's lattice never repeats its parent's probes
+		for (int32 i = 0; i < PyramidNodeProbes; ++i)
+		{
+			const FVector2D Local = Node.Rect.Min + CellSize * FVector2D(i % PyramidLattice + 0.5, i / PyramidLattice + 0.5);
+			const FVector Probe = LocalToWorld.TransformPosition(FVector(Local.X, Local.Y, LocalZ));
+			Starts[i] = FVector(Probe.X, Probe.Y, StartZ);
+			Ends[i] = FVector(Probe.X, Probe.Y, StartZ - Options.TraceDistance);
+			bNodeHits[i] = false;
+		}
+		GroundTracer.TraceProbes(Starts, Ends, NodeHits, bNodeHits, IgnoredActor);
+		NumProbes += PyramidNodeProbes;
+
+		FBigNoobPlaneAccumulator Accumulator;
+		for (int32 i = 0; i < PyramidNodeProbes; ++i)
+		{
+			if (bNodeHits[i])
+			{
+				NodePoints[i] = NodeHits[i].ImpactPoint;
+				Accumulator.Add(NodePoints[i]);
+				OutHits.Add(MoveTemp(NodeHits[i]));
+			}
+		}
+
+		FPlane Plane;
+		if (!Accumulator.GetPlane(Plane))
+		{
+			// Mostly off the ground, there is nothing under this node worth refining
+			continue;
+		}
+		if (Plane.Z < 0.0)
+		{
+			Plane = Plane.Flip();
+		}
+
+		const FVector Normal = Plane.GetSafeNormal();
+		const double ResidualVariance = Accumulator.GetResidualVariance();
+		const bool bDisagrees = !Node.ParentNormal.IsZero() && FVector::DotProduct(Normal, Node.ParentNormal) < NormalThresholdCos;
+		if (Node.Depth < Options.PyramidMaxDepth && (ResidualVariance > ResidualThresholdSq || bDisagrees))
+		{
+			// Every quadrant already has a 2x2 sub-lattice of this node's probes. Quadrants that pass the same test
+			// a child would apply become patches straight away, only the ones that disagree are traced again.
+			constexpr int32 QuadrantLattice = PyramidLattice / 2;
+			const FVector2D QuadrantSize = Node.Rect.GetSize() / 2.0;
+			for (int32 Quadrant = 0; Quadrant < 4; ++Quadrant)
+			{
+				const int32 QuadrantX = Quadrant % 2;
+				const int32 QuadrantY = Quadrant / 2;
+				const FVector2D QuadrantMin = Node.Rect.Min + QuadrantSize * FVector2D(QuadrantX, QuadrantY);
+				const FBox2D QuadrantRect(QuadrantMin, QuadrantMin + QuadrantSize);
+
+				FBigNoobPlaneAccumulator QuadrantAccumulator;
+				for (int32 y = 0; y < QuadrantLattice; ++y)
+				{
+					for (int32 x = 0; x < QuadrantLattice; ++x)
+					{
+						const int32 i = (QuadrantY * QuadrantLattice + y) * PyramidLattice + QuadrantX * QuadrantLattice + x;
+						if (bNodeHits[i])
+						{
+							QuadrantAccumulator.Add(NodePoints[i]);
+						}
+					}
+				}
+
+				FPlane QuadrantPlane;
+				if (QuadrantAccumulator.GetPlane(QuadrantPlane))
+				{
+					QuadrantPlane = QuadrantPlane.Z < 0.0 ? QuadrantPlane.Flip() : QuadrantPlane;
+					if (QuadrantAccumulator.GetResidualVariance() <= ResidualThresholdSq
+						&& FVector::DotProduct(QuadrantPlane.GetSafeNormal(), Normal) >= NormalThresholdCos)
+					{
+						AddPatch(QuadrantRect, QuadrantPlane, Node.Depth + 1, QuadrantAccumulator);
+						continue;
+					}
+				}
+				Pending.Add({ QuadrantRect, Node.Depth + 1, Normal });
+			}
+			continue;
+		}
+
+		AddPatch(Node.Rect, Plane, Node.Depth, Accumulator);
+	}
+	return NumProbes;
+}
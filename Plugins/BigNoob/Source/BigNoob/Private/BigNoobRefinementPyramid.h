@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BigNoobAlignTypes.h"
+#include "Misc/MemStack.h"
+
+class AActor;
+class FBigNoobGroundTracer;
+
+/**
+*	Quadtree probing of the ground under a component's footprint.
+*	Every node traces a 4x4 lattice over its rectangle and fits a plane. A node is split into quadrants only when
+*	its fit residual is above Options.PyramidResidualThreshold or its normal disagrees with its parent's by more
+*	than Options.PyramidNormalThreshold, down to Options.PyramidMaxDepth. A split node judges each quadrant on the
+*	2x2 of its own probes inside it, and only quadrants that fail the same test are traced again.
+*
+*	Probes pass through IgnoredActor, the actor being aligned.
+*	LocalRect is the footprint in the component's local X and Y at height LocalZ, probes start at world height StartZ.
+*	Every hit is appended to OutHits and every leaf with a plane to OutPatches, returns how many probes were traced.
+*	Scratch memory comes from the caller's FMemMark, which must also cover OutHits.
+*/
+int32 RefineGroundPyramid(
+	const FBigNoobGroundTracer& GroundTracer,
+	const AActor* IgnoredActor,
+	const FBigNoobAlignOptions& Options,
+	const FTransform& LocalToWorld,
+	const FBox2D& LocalRect,
+	double LocalZ,
+	double StartZ,
+	TArray<FHitResult, TMemStackAllocator<>>& OutHits,
+	TArray<FBigNoobGroundPatch>& OutPatches);
@@ -2,8 +2,12 @@
 
 #pragma once
 
+#include "HAL/LowLevelMemTracker.h"
 #include "Modules/ModuleManager.h"
 
+/** Every allocation made for alignment: probe and plane buffers, caches, histories and baked tiles. */
+LLM_DECLARE_TAG_API(BigNoob, BIGNOOB_API);
+
 class FBigNoobModule : public IModuleInterface
 {
 public:
@@ -11,4 +15,13 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+#if WITH_EDITOR
+	void RegisterImportHook();
+	void OnAssetPostImport(class UFactory* Factory, UObject* CreatedObject);
+
+	FDelegateHandle PostEngineInitHandle;
+	FDelegateHandle PostImportHandle;
+#endif
 };
@@ -0,0 +1,30 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BigNoobAlignCommandlet.generated.h"
+
+/**
+*	Aligns every tagged actor of a map without an interactive editor session, e.g. overnight on build machines:
+*
+*	UnrealEditor-Cmd Project.uproject -run=BigNoobAlign -Map=/Game/Maps/Level -nullrhi
+*		[-Tag=BigNoobAlign] [-GroundTag=Floor] [-HeightTiles=Level.bnht] [-Estimator=LeastSquares] [-Report=Level.csv] [-NoSave]
+*
+*	The actors go through the same batched path as ActorsAlignCollision. Probing only runs in parallel when every
+*	probe is answered without the physics scene: against the cached BVHs of the static meshes of the actors tagged
+*	-GroundTag, or against baked -HeightTiles. Otherwise it traces the world on one thread and says so.
+*	Every package holding a moved actor, attached untagged actors included, is saved unless -NoSave is given.
+*	Ends with a timing summary and the per-stage latency of BigNoob.Stats.
+*/
+UCLASS()
+class UBigNoobAlignCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBigNoobAlignCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,250 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "BigNoobAlignTypes.generated.h"
+
+class UPrimitiveComponent;
+
+/** How many probe rays, or plane fits, are processed together in SIMD lanes. */
+UENUM(BlueprintType)
+enum class EBigNoobRayPacketWidth : uint8
+{
+	Scalar = 1,
+	Four = 4,
+	Eight = 8,
+	Sixteen = 16,
+};
+
+/** How the ground plane is estimated from the probe hits. */
+UENUM(BlueprintType)
+enum class EBigNoobPlaneEstimator : uint8
+{
+	/** Facet of the hits' convex hull the component would physically rest on. */
+	Support,
+	/** Consensus normal of the planes through hit triples, robust to outliers. */
+	Median,
+	/** Least squares fit through all hits. Best on smooth ground, pulled off by outliers. */
+	LeastSquares,
+};
+
+/** Where probes are placed over a component's footprint. */
+UENUM(BlueprintType)
+enum class EBigNoobProbePattern : uint8
+{
+	/** Regular lattice with StepSize spacing. */
+	Grid,
+	/** Halton sequence in bases 2 and 3. */
+	Halton,
+	/** Roberts' R2 sequence, the most even low-discrepancy layout for small counts. */
+	R2,
+	/** Blue noise, no two probes closer than needed. Breaks up aliasing with tiled geometry best. */
+	PoissonDisk,
+};
+
+/** Leaf of the refinement pyramid: a patch of the footprint and the ground plane fitted under it. */
+USTRUCT(BlueprintType)
+struct FBigNoobGroundPatch
+{
+	GENERATED_BODY()
+
+	/** Centre of the patch on the bottom of the component, in world space. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Patch")
+	FVector Center = FVector::ZeroVector;
+
+	/** Half size of the patch in the component's local X and Y. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Patch")
+	FVector2D Extent = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Patch")
+	FPlane Plane = FPlane(FVector::ZeroVector, FVector::UpVector);
+
+	/** 0 for the whole footprint, each level below halves the patch. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Patch")
+	int32 Depth = 0;
+
+	/** RMS distance of the patch's hits from its plane. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Patch")
+	float ResidualRMS = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Patch")
+	int32 NumHits = 0;
+};
+
+/** Settings used when baking the walkable ground of a level into height tiles. */
+USTRUCT(BlueprintType)
+struct FBigNoobHeightTileBakeSettings
+{
+	GENERATED_BODY()
+
+	/** Distance between height samples, in world units. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1.0"))
+	float CellSize = 50.0f;
+
+	/** Samples along each edge of a tile. Tiles are the unit that gets paged in at runtime. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "4", ClampMax = "1024"))
+	int32 TileResolution = 64;
+
+	/** Walkable surfaces stored per sample, such as a bridge deck above the terrain. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1", ClampMax = "16"))
+	int32 MaxLayers = 2;
+
+	/** Minimum vertical gap between two stored layers. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1.0"))
+	float MinLayerSeparation = 100.0f;
+
+	/** Steepest surface, in degrees, that still counts as ground. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "0.0", ClampMax = "90.0"))
+	float WalkableFloorAngle = 60.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+};
+
+/** Settings used when aligning an actor's components to the ground below them. */
+USTRUCT(BlueprintType)
+struct FBigNoobAlignOptions
+{
+	GENERATED_BODY()
+
+	/** Spacing of the probe lattice, in the component's local units. The lattice follows the component's yaw. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "1.0"))
+	float StepSize = 50.0f;
+
+	/**
+	*	Layout of the probes. The low-discrepancy patterns do not alias with stairs or floor tiles,
+	*	so they reach the grid's fit accuracy with far fewer traces.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes")
+	EBigNoobProbePattern ProbePattern = EBigNoobProbePattern::Grid;
+
+	/** Probes per component for the low-discrepancy patterns, never more than the grid would trace. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "3", ClampMax = "256", EditCondition = "ProbePattern != EBigNoobProbePattern::Grid"))
+	int32 MaxProbes = 24;
+
+	/**
+	*	Trace the probes a few at a time in a coarse to fine order and stop once the ground plane is known,
+	*	so flat floors only cost a handful of traces.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes")
+	bool bProgressive = false;
+
+	/** Progressive sampling stops when the fitted normal's 95% confidence cone is narrower than this, in degrees. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "0.01", EditCondition = "bProgressive"))
+	float ConfidenceConeDegrees = 1.0f;
+
+	/** How far below the bottom of the component bounds each probe traces. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "0.0"))
+	float TraceDistance = 1000.0f;
+
+	/**
+	*	Trace each probe only across a short window around the ground height predicted from the hits so far,
+	*	or from where the component rests now. Misses widen the window until it covers the full trace distance.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes")
+	bool bAdaptiveRayLength = false;
+
+	/** Half height of the first adaptive trace window. Probes may start up to this far above the component bounds. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "1.0", EditCondition = "bAdaptiveRayLength"))
+	float AdaptiveRayMargin = 25.0f;
+
+	/**
+	*	Replace the probe layout with a quadtree: trace a 4x4 lattice, fit, and only split the quadrants whose fit
+	*	residual or normal disagreement with their parent is too large. Uneven ground gets dense probes, flat ground stays sparse.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes")
+	bool bRefinementPyramid = false;
+
+	/** Deepest quadtree level, the finest patches are 1 / 2^PyramidMaxDepth of the footprint. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "0", ClampMax = "8", EditCondition = "bRefinementPyramid"))
+	int32 PyramidMaxDepth = 3;
+
+	/** Patches whose hits lie further than this RMS distance from their plane are split. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "0.0", EditCondition = "bRefinementPyramid"))
+	float PyramidResidualThreshold = 2.0f;
+
+	/** Patches whose normal differs from their parent's by more than this, in degrees, are split. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "0.0", EditCondition = "bRefinementPyramid"))
+	float PyramidNormalThreshold = 5.0f;
+
+	/**
+	*	Keep every component's probe hits between calls and slide them along the ground to the probes' new positions.
+	*	Only probes that moved into a new ground cell, or whose ground moved or disappeared, are traced again.
+	*	With the LeastSquares estimator the plane fit is kept as well and only updated for the probes whose hit changed.
+	*	Meant for actors that are re-aligned every tick while they move. Not used by the refinement pyramid.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes")
+	bool bReuseProbeHistory = false;
+
+	/** Size of the world grid cells a probe can move within and still reuse its previous hit. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes", meta = (ClampMin = "1.0", EditCondition = "bReuseProbeHistory"))
+	float ProbeHistoryCellSize = 100.0f;
+
+	/** Channel used for world traces. Ignored when tracing explicit ground components. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Probes")
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+	/**
+	*	Primitives to align against, such as a specific floor mesh or landscape.
+	*	When not empty, probes are traced against these components only and the world broadphase is skipped.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ground")
+	TArray<TObjectPtr<UPrimitiveComponent>> GroundComponents;
+
+	/**
+	*	Raycast static mesh ground components against a cached triangle BVH instead of their physics bodies.
+	*	The BVH needs no physics-scene lock, so probes for many components can be traced in parallel.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ground")
+	bool bUseGroundMeshCache = false;
+
+	/** LOD of the ground static meshes used to build the cached BVH. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ground", meta = (ClampMin = "0", EditCondition = "bUseGroundMeshCache"))
+	int32 GroundMeshLOD = 0;
+
+	/** Probes traced per BVH traversal against cached ground. Lattice probes are coherent, so wider packets share most of the traversal. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ground", meta = (EditCondition = "bUseGroundMeshCache"))
+	EBigNoobRayPacketWidth RayPacketWidth = EBigNoobRayPacketWidth::Eight;
+
+	/**
+	*	Ground height tiles baked with BakeGroundHeightTiles.
+	*	When set, probes become bilinear lookups into the memory-mapped tiles and nothing is traced at all.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ground", meta = (FilePathFilter = "bnht"))
+	FFilePath GroundHeightTiles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fitting")
+	EBigNoobPlaneEstimator Estimator = EBigNoobPlaneEstimator::Support;
+
+	/**
+	*	Least squares fits, and the rotations built from every fit, are computed together in SIMD lanes
+	*	across all components at the same attachment depth. Scalar solves each least squares fit alone.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fitting")
+	EBigNoobRayPacketWidth PlaneFitBatchWidth = EBigNoobRayPacketWidth::Eight;
+
+	/**
+	*	Align the mesh's own base plane, fitted from its lowest vertices, instead of assuming its local up is +Z.
+	*	The fit is cached per static mesh.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fitting")
+	bool bAlignMeshBasePlane = true;
+
+	/** Also move the component along the ground normal so its base plane lies on the ground plane. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fitting")
+	bool bSnapToGround = false;
+
+	/** Draw and log every probe hit. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
+	bool bDrawDebug = true;
+
+	/**
+	*	CSV file that gets one row per aligned component or instance after every run, with its mesh, probe and hit
+	*	counts, sample, trace, fit and apply milliseconds and the estimator, for finding the content that is expensive to align.
+	*	Relative paths are under Saved/Profiling. Left empty, no report is written.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug", meta = (FilePathFilter = "csv"))
+	FFilePath ProfileReport;
+};
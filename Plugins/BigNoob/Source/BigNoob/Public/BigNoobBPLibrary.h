@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "BigNoobAlignTypes.h"
 #include "BigNoobBPLibrary.generated.h"
 
 /* 
@@ -32,4 +33,33 @@ class UBigNoobBPLibrary : public UBlueprintFunctionLibrary
 
 	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
 	static void ActorSceneComponentsAlignCollision(AActor* InActor);
+
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
+	static void ActorSceneComponentsAlignCollisionWithOptions(AActor* InActor, const FBigNoobAlignOptions& Options);
+
+	/** Aligns the components of many actors in one batch. Probes run in parallel when every ground component uses the cached BVH. */
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
+	static void ActorsAlignCollision(const TArray<AActor*>& InActors, const FBigNoobAlignOptions& Options);
+
+	/**
+	*	ActorsAlignCollision that also returns every actor with a component it wrote, attached actors included,
+	*	i.e. the actors whose level or external package needs saving.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
+	static void ActorsAlignCollisionWithMovedActors(const TArray<AActor*>& InActors, const FBigNoobAlignOptions& Options, TArray<AActor*>& OutMovedActors);
+
+	/** Samples the walkable ground inside Bounds into a height tile file that alignment can use instead of tracing. */
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting", meta = (WorldContext = "WorldContextObject"))
+	static bool BakeGroundHeightTiles(const UObject* WorldContextObject, const FBox& Bounds, const FBigNoobHeightTileBakeSettings& Settings, const FString& Filename);
+
+	/**
+	*	Probes the ground under a component with the refinement pyramid without moving it.
+	*	Returns the plane fitted over every hit, OutPatches receives the plane of each leaf patch.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
+	static FPlane ProbeGroundPatches(UPrimitiveComponent* Component, const FBigNoobAlignOptions& Options, TArray<FBigNoobGroundPatch>& OutPatches);
+
+	/** Attaches footprint data to the mesh, or refreshes it, so alignment no longer reads the mesh's vertices. Editor only, the mesh must be saved afterwards. */
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
+	static class UBigNoobFootprintUserData* AddFootprintUserData(class UStaticMesh* StaticMesh);
 };
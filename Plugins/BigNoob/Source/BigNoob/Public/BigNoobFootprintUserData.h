@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "BigNoobFootprintUserData.generated.h"
+
+class UStaticMesh;
+
+/**
+*	Alignment data that only depends on the static mesh, computed once in the editor and saved with the asset.
+*	When a mesh carries it, alignment reads the base plane and probe layout from here and never
+*	touches the mesh's render or collision data at runtime.
+*	It is rebuilt whenever the owning mesh is rebuilt or reimported, and checked again before every save and cook.
+*/
+UCLASS(BlueprintType)
+class UBigNoobFootprintUserData : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	/** Spacing of the probe points inside the footprint, in mesh local units. */
+	UPROPERTY(EditAnywhere, Category = "Footprint", meta = (ClampMin = "1.0"))
+	float ProbeSpacing = 50.0f;
+
+	/** Plane the mesh rests on in local space, the normal is the mesh's up. Fitted with the support estimator. */
+	UPROPERTY(VisibleAnywhere, Category = "Footprint")
+	FPlane BasePlane = FPlane(FVector::ZeroVector, FVector::UpVector);
+
+	/** Convex hull of the base vertices, in the base plane's own 2D basis (see GetBaseAxes). */
+	UPROPERTY(VisibleAnywhere, Category = "Footprint")
+	TArray<FVector2D> FootprintHull;
+
+	/** Local space points on the base plane to probe the ground under: the hull corners plus a lattice inside it. */
+	UPROPERTY(VisibleAnywhere, Category = "Footprint")
+	TArray<FVector> ProbePoints;
+
+	/** Local space point alignment treats as the centre of mass. */
+	UPROPERTY(VisibleAnywhere, Category = "Footprint")
+	FVector CenterOfMass = FVector::ZeroVector;
+
+	/** Recomputes everything above from the mesh's LOD0 vertices. Needs CPU access to the vertex data. */
+	bool Rebuild(const UStaticMesh& StaticMesh);
+
+	/** Whether the data was built from the mesh's current render data. Always true in cooked builds. */
+	bool IsUpToDate(const UStaticMesh& StaticMesh) const;
+
+	/** Two axes spanning the base plane, FootprintHull is expressed in them. */
+	void GetBaseAxes(FVector& OutAxisX, FVector& OutAxisY) const;
+
+	FBox2D GetFootprintBounds() const;
+
+	/** Whether a point in base plane space lies inside the footprint hull. */
+	bool FootprintContains(const FVector2D& Point) const;
+
+	/** Returns the mesh's footprint data, adding and building it first if the mesh has none. */
+	static UBigNoobFootprintUserData* FindOrAdd(UStaticMesh* StaticMesh);
+
+#if WITH_EDITOR
+	virtual void PostEditChangeOwner() override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#endif
+
+private:
+#if WITH_EDITORONLY_DATA
+	/** Derived data key of the render data this was built from. */
+	UPROPERTY()
+	FString SourceRenderDataKey;
+#endif
+};
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "BigNoobProbeHistory.generated.h"
+
+class FBigNoobPlaneTracker;
+class UPrimitiveComponent;
+
+/**
+*	Last traced result of every probe of one aligned component or instance.
+*	Probe layouts are generated in the component's own space, so probe i is the same point of the footprint
+*	on every call and its previous hit can be slid along the ground it hit to wherever the probe is now.
+*/
+struct FBigNoobProbeHistory
+{
+	FBigNoobProbeHistory();
+	~FBigNoobProbeHistory();
+
+	/**
+	*	Fills in every probe whose previous hit is still usable and flags it in bOutReused.
+	*	A hit is reused while its probe stays inside the same ground cell, the component it hit has not moved,
+	*	and the reprojected hit still lies on the probe's ray.
+	*/
+	void Reproject(int32 FirstProbe, TArrayView<const FVector> Starts, TArrayView<const FVector> Ends, double CellSize,
+		TArrayView<FHitResult> OutHits, TArrayView<bool> bOutHits, TArrayView<bool> bOutReused) const;
+
+	/**
+	*	Stores a freshly traced probe and moves its plane tracker slot to the new hit.
+	*	Reprojected hits are never recorded, so errors do not accumulate and reused probes leave the tracker alone.
+	*/
+	void Record(int32 Probe, const FVector& Start, const FHitResult& Hit, bool bHit, double CellSize);
+
+	/** Drops the history when the probe layout changed. */
+	void Prepare(int32 NumProbes);
+
+	/** Forgets every probe from FirstProbe on, e.g. the ones progressive sampling did not reach this time. */
+	void ForgetFrom(int32 FirstProbe);
+
+	/**
+	*	Least squares fit over the recorded hit of every probe, one slot per probe.
+	*	A reprojected hit lies on the ground plane of its recorded one, so on planar ground the fit is the same.
+	*/
+	FBigNoobPlaneTracker& GetPlaneTracker() { return *PlaneTracker; }
+
+private:
+	struct FRecord
+	{
+		FHitResult Hit;
+		FVector2D ProbeXY = FVector2D::ZeroVector;
+		FIntPoint GroundCell = FIntPoint::ZeroValue;
+		FVector GroundLocation = FVector::ZeroVector;
+		FQuat GroundRotation = FQuat::Identity;
+		bool bValid = false;
+		bool bHit = false;
+	};
+
+	TArray<FRecord> Records;
+	TUniquePtr<FBigNoobPlaneTracker> PlaneTracker;
+};
+
+/** Keeps the probe history of every component aligned with probe reuse enabled, for the lifetime of the world. */
+UCLASS()
+class UBigNoobProbeHistorySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Game thread only. The history stays at the same address until it is pruned or reset. */
+	FBigNoobProbeHistory& FindOrAdd(const UPrimitiveComponent* Component, int32 InstanceIndex);
+
+	/** Forgets the histories of components that no longer exist. */
+	void PruneStale();
+
+	UFUNCTION(BlueprintCallable, Category = "BigNoobTesting")
+	void ResetProbeHistory();
+
+private:
+	using FKey = TPair<TObjectKey<UPrimitiveComponent>, int32>;
+	TMap<FKey, TUniquePtr<FBigNoobProbeHistory>> Histories;
+};